@@ -4,9 +4,11 @@
 #include "GoalActor.h"
 #include "NavigationSystem.h"
 #include "NavMesh/RecastNavMesh.h"
-#include "AITypes.h"
 #include "DebugStringsComponent.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "SmoothNavPathSubsystem.h"
+#include "SmoothNavPathGenerator.h"
+#include "SmoothNavReplay.h"
+#include "NavFilters/NavigationQueryFilter.h"
 
 AATestingNavigatingActor::AATestingNavigatingActor()
 {
@@ -25,6 +27,8 @@ void AATestingNavigatingActor::PostEditChangeProperty(FPropertyChangedEvent& Pro
 	if ((PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(AATestingNavigatingActor, bRecalculateSmoothPath)) 
 		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(AATestingNavigatingActor, NavPathDrawType))
 		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(AATestingNavigatingActor, GoalActor))
+		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(AATestingNavigatingActor, SmoothPathStorage))
+		|| (PropertyChangedEvent.MemberProperty != nullptr && PropertyChangedEvent.MemberProperty->GetFName() == GET_MEMBER_NAME_CHECKED(AATestingNavigatingActor, AgentProperties))
 		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(FSmoothNavPathConfig, Bias1_DistanceScalar))
 		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(FSmoothNavPathConfig, Bias2_MaxDistanceOffset))
 		|| (PropertyChangedEvent.Property != nullptr && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(FSmoothNavPathConfig, Bias2_MinDistanceOffset))
@@ -41,9 +45,47 @@ void AATestingNavigatingActor::PostEditChangeProperty(FPropertyChangedEvent& Pro
 			SmoothPathConfigurator.ResetToDefaults();
 		}
 
-		// Proceed to generate path
+		// Proceed to generate path. Slider drags fire this many times per second, so the work is coalesced.
+		RequestPathRegeneration();
+	}
+}
+
+void AATestingNavigatingActor::BakeSmoothPath()
+{
+	Modify();
+
+	// Make sure the path is regenerated from scratch instead of reusing the previous bake, a prediction or the last generated path
+	BakedPath.Reset();
+	SmoothedPath.Reset();
+	SmoothedPathNavTiles.Reset();
+	SmoothPathSource = ESmoothPathSource::None;
+	{
+		TGuardValue<bool> noPredictionGuard(bPredictivePreSmoothing, false);
 		GeneratePath();
 	}
+
+	// Pathfinding or navigation data resolution failed, the path of this call is empty
+	if(SmoothedPath.IsEmpty() || !IsValid(GoalActor))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: Failed to bake smooth path, no path could be generated."), *GetName());
+		return;
+	}
+
+	BakedPath.Path = SmoothedPath;
+	BakedPath.NavTileIndices = SmoothedPathNavTiles;
+	BakedPath.NavTilesHash = CalculateNavTilesHash(SmoothedPathNavTiles);
+	BakedNavTilesHashCache = BakedPath.NavTilesHash;
+	BakedNavTilesHashNavMesh = RecastNavMesh.Get();
+	BakedPath.StartLocation = GetActorLocation();
+	BakedPath.GoalLocation = GoalActor->GetActorLocation();
+	BakedPath.ConfigHash = GetPathConfigHash();
+}
+
+void AATestingNavigatingActor::ClearBakedSmoothPath()
+{
+	Modify();
+	BakedPath.Reset();
+	BakedNavTilesHashCache.Reset();
 }
 #endif
 
@@ -51,190 +93,348 @@ void AATestingNavigatingActor::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 
-	GeneratePath();
+	RequestPathRegeneration();
 }
 
-void AATestingNavigatingActor::GeneratePath()
+void AATestingNavigatingActor::BeginDestroy()
 {
-	NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
-	if (NavSystem)
+	if(PathRegenerationTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PathRegenerationTickerHandle);
+		PathRegenerationTickerHandle.Reset();
+	}
+
+	StopObservingNavPath();
+
+	// Prediction queries bound to this actor are dropped with it, release what they reserved
+	if(!InFlightPredictionKeys.IsEmpty())
 	{
-		NavigationData = NavSystem->GetDefaultNavDataInstance();
-		if (NavigationData && IsValid(GoalActor))
+		if(USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld()))
 		{
-			if(!GoalActor->OnConstructionEvent.IsAlreadyBound(this, &AATestingNavigatingActor::GeneratePath))
+			for(const uint32 predictionKey : InFlightPredictionKeys)
 			{
-				GoalActor->OnConstructionEvent.AddUniqueDynamic(this, &AATestingNavigatingActor::GeneratePath);
+				smoothNavPathSubsystem->CancelPrediction(predictionKey);
 			}
-			
-			// Get the optimal navigation path from the engine
-			const FPathFindingResult pathFindingResult = NavSystem->FindPathSync(FPathFindingQuery(this, *NavigationData, GetActorLocation(), GoalActor->GetActorLocation(), UNavigationQueryFilter::GetQueryFilter(*NavigationData, this, NavigationFilterClass), nullptr, UE_BIG_NUMBER, true));
-			if (pathFindingResult.IsSuccessful())
+		}
+		InFlightPredictionKeys.Empty();
+	}
+
+	Super::BeginDestroy();
+}
+
+void AATestingNavigatingActor::GeneratePath()
+{
+	// A synchronous generation supersedes anything that is still pending
+	PendingPathQueryID = INVALID_NAVQUERYID;
+	
+	if (PreparePathGeneration())
+	{
+		// Get the optimal navigation path from the engine
+		const FPathFindingResult pathFindingResult = NavSystem->FindPathSync(MakePathFindingQuery());
+		if (pathFindingResult.IsSuccessful())
+		{
+			SmoothPath(pathFindingResult.Path);
+			ObserveNavPath(pathFindingResult.Path);
+			SchedulePredictiveSmoothing();
+		}
+	}
+}
+
+void AATestingNavigatingActor::RequestPathRegeneration()
+{
+	// Game worlds expect the path right away
+	const UWorld* world = GetWorld();
+	if(!world || world->IsGameWorld())
+	{
+		GeneratePath();
+		return;
+	}
+
+	// Every new request pushes the deadline back, so a drag only regenerates once it settles (or at most once per frame with no debounce)
+	PathRegenerationDeadline = FPlatformTime::Seconds() + EditorRegenerationDebounce;
+	if(!PathRegenerationTickerHandle.IsValid())
+	{
+		PathRegenerationTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &AATestingNavigatingActor::TickPendingPathRegeneration));
+	}
+}
+
+bool AATestingNavigatingActor::TickPendingPathRegeneration(float deltaTime)
+{
+	if(FPlatformTime::Seconds() < PathRegenerationDeadline)
+	{
+		return true;
+	}
+
+	PathRegenerationTickerHandle.Reset();
+	GeneratePathAsync();
+	
+	// Unregister the ticker
+	return false;
+}
+
+void AATestingNavigatingActor::GeneratePathAsync()
+{
+	PendingPathQueryID = INVALID_NAVQUERYID;
+	
+	if (PreparePathGeneration())
+	{
+		PendingPathQueryID = NavSystem->FindPathAsync(NavigationData->GetConfig(), MakePathFindingQuery(), FNavPathQueryDelegate::CreateUObject(this, &AATestingNavigatingActor::OnAsyncPathFound));
+	}
+}
+
+void AATestingNavigatingActor::OnAsyncPathFound(uint32 queryID, ENavigationQueryResult::Type result, FNavPathSharedPtr path)
+{
+	// Ignore results of queries that were superseded in the meantime
+	if(queryID != PendingPathQueryID)
+	{
+		return;
+	}
+	PendingPathQueryID = INVALID_NAVQUERYID;
+
+	// Smoothing queries the navmesh, so it stays on the game thread where the delegate is called
+	if(result == ENavigationQueryResult::Success && NavigationData && RecastNavMesh)
+	{
+		SmoothPath(path);
+		ObserveNavPath(path);
+		SchedulePredictiveSmoothing();
+	}
+}
+
+void AATestingNavigatingActor::ObserveNavPath(FNavPathSharedPtr path)
+{
+	StopObservingNavPath();
+	if(!path.IsValid())
+	{
+		return;
+	}
+
+	// Let the engine repath when the tiles under the corridor change, the observer then only has to resmooth
+	ObservedNavPath = path;
+	ObservedNavPath->EnableRecalculationOnInvalidation(true);
+	ObservedNavPathHandle = ObservedNavPath->AddObserver(FNavigationPath::FPathObserverDelegate::FDelegate::CreateUObject(this, &AATestingNavigatingActor::OnObservedNavPathEvent));
+}
+
+void AATestingNavigatingActor::StopObservingNavPath()
+{
+	if(ObservedNavPath.IsValid())
+	{
+		ObservedNavPath->RemoveObserver(ObservedNavPathHandle);
+		ObservedNavPath.Reset();
+	}
+	ObservedNavPathHandle.Reset();
+}
+
+void AATestingNavigatingActor::OnObservedNavPathEvent(FNavigationPath* path, ENavPathEvent::Type event)
+{
+	if(!ObservedNavPath.IsValid() || ObservedNavPath.Get() != path)
+	{
+		return;
+	}
+
+	switch (event)
+	{
+	case ENavPathEvent::UpdatedDueToNavigationChanged:
+		{
+			// Only paths whose corridor crossed the rebuilt tiles get here
+			if(NavigationData && RecastNavMesh)
 			{
-				SmoothPath(pathFindingResult.Path);
+				SmoothPath(ObservedNavPath);
 			}
 		}
+		break;
+
+	case ENavPathEvent::RePathFailed:
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: Repath after a navmesh change failed, keeping the previous smooth path."), *GetName());
+		}
+		break;
+
+	default:
+		break;
 	}
 }
 
-TArray<FVector> AATestingNavigatingActor::SmoothPath(FNavPathSharedPtr path)
+void AATestingNavigatingActor::OnNavigationGenerationFinished(ANavigationData* navData)
 {
-	if (FNavigationPath* navPath = path.Get()) 
+	if(USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld()))
 	{
-		RecastNavMesh = Cast<ARecastNavMesh>(NavigationData);
-		
-		// Redundant really, but paranoia
-		ensure(NavSystem);
-		ensure(RecastNavMesh);
-		ensure(NavigationData);
+		smoothNavPathSubsystem->InvalidatePredictions();
+	}
 
-		TArray<FNavPathPoint>& navPathPoints = navPath->GetPathPoints();
+	if(navData != NavigationData)
+	{
+		return;
+	}
 
-		// Flush all previous debug drawing
-		FlushPersistentDebugLines(GetWorld());
-		if(DebugStringsComponent)
+	// Tiles only change while the navmesh is being built, the cached tile hash of the bake stays valid until the build finishes
+	BakedNavTilesHashCache.Reset();
+
+	// Baked paths have no engine path to be invalidated through, so verify their tile hash after every rebuild
+	if(bUsingBakedPath && BakedPath.NavTilesHash != GetBakedNavTilesHash())
+	{
+		RequestPathRegeneration();
+	}
+}
+
+bool AATestingNavigatingActor::ResolveNavigationData()
+{
+	NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSystem)
+	{
+		// Raycasts and clamps have to run against the navmesh eroded for this agent type
+		USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld());
+		const FSmoothNavAgentTypeData* agentTypeData = AgentProperties.IsValid() && smoothNavPathSubsystem ? smoothNavPathSubsystem->GetAgentTypeData(AgentProperties) : nullptr;
+		NavigationData = agentTypeData ? agentTypeData->NavigationData.Get() : NavSystem->GetDefaultNavDataInstance();
+		ExtraAgentClearance = agentTypeData ? agentTypeData->ExtraClearance : 0.f;
+		RecastNavMesh = Cast<ARecastNavMesh>(NavigationData);
+		if(!NavSystem->OnNavigationGenerationFinishedDelegate.IsAlreadyBound(this, &AATestingNavigatingActor::OnNavigationGenerationFinished))
 		{
-			DebugStringsComponent->ClearDebugText();
+			NavSystem->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(this, &AATestingNavigatingActor::OnNavigationGenerationFinished);
 		}
-		
-		// Draw the optimal non smoothed engine path
-		DebugDrawNavigationPath(navPathPoints, FColor::Blue);
-		
-		// Smoothing of the points with a custom algorithm including cubic Bezier interpolation
-		TArray<FVector> bezierSmoothedLocations;
-		for (int32 i = 0; i < navPathPoints.Num(); i++)
+	}
+
+	return NavSystem && NavigationData;
+}
+
+bool AATestingNavigatingActor::PreparePathGeneration()
+{
+	if (ResolveNavigationData())
+	{
+		if (IsValid(GoalActor))
 		{
-			// We are generating the point from current to next, so the last point is already generated
-			if (i + 1 == navPathPoints.Num()) {
-				break;
-			}
-			
-			// Experimental bias. We need to start with some sort of curve before we make any adjustments.
-			FNavPathPoint currentP = navPathPoints[i];
-			if(!bezierSmoothedLocations.IsEmpty())
+			// Levels saved before regeneration was debounced may still have the direct binding serialized
+			GoalActor->OnConstructionEvent.RemoveDynamic(this, &AATestingNavigatingActor::GeneratePath);
+			if(!GoalActor->OnConstructionEvent.IsAlreadyBound(this, &AATestingNavigatingActor::RequestPathRegeneration))
 			{
-				currentP.Location = bezierSmoothedLocations[bezierSmoothedLocations.Num() - 1];
+				GoalActor->OnConstructionEvent.AddUniqueDynamic(this, &AATestingNavigatingActor::RequestPathRegeneration);
 			}
-			FNavPathPoint nextP = navPathPoints[i + 1];
 
-			//Sample current segment direction
-			FVector currentSegmentDir = nextP.Location - navPathPoints[i].Location;
-			currentSegmentDir.Normalize();
+			// Static routes and predicted goals can skip pathfinding and smoothing altogether
+			return !TryUseBakedPath() && !TryUsePredictedPath();
+		}
+	}
 
-			// First experimental bias 
-			FVector experimentalBias = nextP.Location - currentP.Location;
-			CalculateFirstBiasPoint(experimentalBias, currentP, nextP, path, bezierSmoothedLocations);
+	return false;
+}
 
-			// Second experimental bias. I am sampling the direction vector of the next segment and invert it in order to choose a decent location for the second bias.
-			// This algorithm ensures that the angles will not be too sharp since it will curve out slightly before curving into the turning point.
-			FVector experimentalBias2 = FAISystem::InvalidLocation;
-			if(i + 2 < navPathPoints.Num())
-			{
-				FNavPathPoint nextNextP = navPathPoints[i + 2];
-				FVector nextSegmentDir = nextNextP.Location - nextP.Location;
-				nextSegmentDir.Normalize();
-				
-				FVector currentPToNextNextPDir = nextNextP.Location - currentP.Location;
-				currentPToNextNextPDir.Normalize();
-				currentPToNextNextPDir *= -1;
-
-				// Tiny offset due to potential precision inaccuracies from nav raycast
-				constexpr float tinyOffset = 10.f;
-				
-				// Attempt to skip nav points in case the angle is too small and the resulting segment from current to skip location is fully on navmesh (EXPERIMENTAL)
-				float angle = GetAngleBetweenUnitVectors(currentSegmentDir, nextSegmentDir, EAngleUnits::Degrees);
-				if(SmoothPathConfigurator.bNavPointSkipping && angle <= SmoothPathConfigurator.MinAngleSkipThreshold && IsSegmentIsFullyOnNavmesh(currentP.Location, nextNextP.Location + currentPToNextNextPDir * tinyOffset))
-				{
-					nextP = nextNextP;
+bool AATestingNavigatingActor::EvaluateCandidateGoals(TArray<FSmoothPathGoalCandidate>& outCandidates)
+{
+	outCandidates.Reset(CandidateGoalActors.Num());
+	if(!ResolveNavigationData() || !RecastNavMesh)
+	{
+		return false;
+	}
 
-					// Recalculate first bias
-					CalculateFirstBiasPoint(experimentalBias, currentP, nextP, path, bezierSmoothedLocations);
+	// A single Dijkstra exploration from the source gives the cost to every poly within the search distance, so each goal is only a poly lookup instead of its own A* query
+	const FSharedConstNavQueryFilter queryFilter = UNavigationQueryFilter::GetQueryFilter(*NavigationData, this, NavigationFilterClass);
+	FRecastDebugPathfindingData exploredNodes(ERecastDebugPathfindingFlags::Basic);
+	TArray<NavNodeRef> reachablePolys;
+	if(!RecastNavMesh->GetPolysWithinPathingDistance(GetActorLocation(), CandidateSearchDistance, reachablePolys, queryFilter, this, &exploredNodes))
+	{
+		return false;
+	}
 
-					// Recalculate current direction
-					currentSegmentDir = nextP.Location - currentP.Location;
-					currentSegmentDir.Normalize();
+	const FVector queryExtent = NavigationData->GetConfig().DefaultQueryExtent;
+	for(const TObjectPtr<AGoalActor>& candidateGoal : CandidateGoalActors)
+	{
+		if(!IsValid(candidateGoal))
+		{
+			continue;
+		}
 
-					// Need to increment the iterator once
-					++i;
+		FSmoothPathGoalCandidate& candidate = outCandidates.AddDefaulted_GetRef();
+		candidate.GoalActor = candidateGoal;
 
-					// Recalculate next segment dir
-					if(i + 2 < navPathPoints.Num())
-					{
-						nextNextP = navPathPoints[i + 2];
-						nextSegmentDir = nextNextP.Location - nextP.Location;
-						nextSegmentDir.Normalize();
+		const FVector goalLocation = candidateGoal->GetActorLocation();
+		const NavNodeRef goalPoly = RecastNavMesh->FindNearestPoly(goalLocation, queryExtent, queryFilter, this);
+		if(const FRecastDebugPathfindingNode* goalNode = goalPoly != INVALID_NAVNODEREF ? exploredNodes.Nodes.Find(FRecastDebugPathfindingNode(goalPoly)) : nullptr)
+		{
+			// The distance exploration only accumulates into the node totals (Cost stays 0). They are measured to the node position, add the remaining stretch within the goal poly.
+			candidate.PathCost = goalNode->TotalCost + FVector::Dist(FVector(goalNode->NodePos), goalLocation);
+			candidate.bReachable = true;
+		}
+	}
 
-						// Recalculate current direction
-						angle = GetAngleBetweenUnitVectors(currentSegmentDir, nextSegmentDir, EAngleUnits::Degrees);
-					}
-				}
-				
-				// Debug angles
-				if(SmoothPathConfigurator.bEnableExtraDebugInfo && DebugStringsComponent)
-				{
-					DebugStringsComponent->DrawDebugStringAtLocation(FString::SanitizeFloat(angle), FColor::White, 1.5f, nextP.Location + FVector(0,0, 50));
-				}
+	outCandidates.Sort([](const FSmoothPathGoalCandidate& a, const FSmoothPathGoalCandidate& b)
+	{
+		return a.bReachable != b.bReachable ? a.bReachable : a.PathCost < b.PathCost;
+	});
+	return !outCandidates.IsEmpty() && outCandidates[0].bReachable;
+}
 
-				// Determine the second bias position offset based on the angle. Sharper angles usually need a larger offset 
-				float distanceOffset = UKismetMathLibrary::MapRangeClamped(angle, 0.f, 90.f, SmoothPathConfigurator.Bias2_MinDistanceOffset, SmoothPathConfigurator.Bias2_MaxDistanceOffset);
-				experimentalBias2 = nextSegmentDir;
-				experimentalBias2 *= -1;
-				experimentalBias2 *= distanceOffset;
-				experimentalBias2 += nextP.Location;
-			}
-			
-			// Adjust the second bias in case it's outside of navmesh
-			FVector testLocBias2;
-			if(FAISystem::IsValidLocation(experimentalBias2) && !IsSegmentIsFullyOnNavmesh(nextP.Location, experimentalBias2, testLocBias2))
-			{
-				DebugStringsComponent->DrawDebugStringAtLocation(TEXT("SEGMENT OUT OF BOUNDS!"), FColor::Emerald, 1.5f, experimentalBias2);
-				experimentalBias2 = testLocBias2;
-			}
-			
-			// Apply a little offset to next point. It behaves well with bezier curves where there can be some inconsistencies at key points depending on the bias of the next bezier curve segment.
-			// Tiny additional offset because if nav point is perfectly at the angle of navbounds, the nav raycast can fail due to precision
-			constexpr float miniOffsetNextPoint = 10.f;
-			FVector nextPointLocWithOffset = nextP.Location + currentSegmentDir * (SmoothPathConfigurator.NextPointOffset + miniOffsetNextPoint);
-			
-			// Adjust the next point offset in case it's outside of navmesh
-			FVector testNextPointLocWithOffset;
-			if(!IsSegmentIsFullyOnNavmesh(nextP.Location + currentSegmentDir * 5.f, nextPointLocWithOffset, testNextPointLocWithOffset))
-			{
-				nextP.Location = testNextPointLocWithOffset;
-			}
-			else
-			{
-				// Otherwise the vector segment is on the navmesh
-				nextP.Location = nextPointLocWithOffset;
-			}
-			
-			// More debugging
-			if(SmoothPathConfigurator.bEnableExtraDebugInfo)
-			{
-				// Next location
-				DrawDebugPoint(GetWorld(), nextP.Location, 22.f, FColor::Green, true, -1.f, 0);
+void AATestingNavigatingActor::SelectBestCandidateGoal()
+{
+	TArray<FSmoothPathGoalCandidate> candidates;
+	if(!EvaluateCandidateGoals(candidates))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: None of the candidate goals is reachable."), *GetName());
+		return;
+	}
 
-				// Bias 1
-				DrawDebugLine(GetWorld(), currentP.Location, experimentalBias, FColor::Red, true, -1.f, 0, 4.f);
-				DrawDebugPoint(GetWorld(), experimentalBias, 22.f, FColor::Red, true, -1.f, 0);
+	// Only the winner is pathed and smoothed. Goes through SetGoalActor so the previous goal stops triggering regenerations.
+	SetGoalActor(candidates[0].GoalActor);
+}
 
-				// Bias 2
-				if(FAISystem::IsValidLocation(experimentalBias2))
-				{
-					DrawDebugLine(GetWorld(), nextP.Location, experimentalBias2, FColor::Yellow, true, -1.f, 0, 4.f);
-					DrawDebugPoint(GetWorld(), experimentalBias2, 22.f, FColor::Yellow, true, -1.f, 0);
-				}
-			}
-			
-			// Using bezier and cubic bezier curve equations (depending on the access to the data that we have), generate intermediate interpolated location points
-			for (float t = 0.0; t <= 1.0; t += 0.1f) {
-				FVector pointOnCurve = FAISystem::IsValidLocation(experimentalBias2) ?  GetCubicBezierPoint(t, currentP.Location, experimentalBias, experimentalBias2, nextP.Location) : GetBezierPoint(t, currentP.Location, experimentalBias, nextP.Location);
-				bezierSmoothedLocations.Emplace(pointOnCurve);
-			}
+void AATestingNavigatingActor::SetGoalActor(AGoalActor* newGoalActor)
+{
+	if(IsValid(GoalActor))
+	{
+		GoalActor->OnConstructionEvent.RemoveDynamic(this, &AATestingNavigatingActor::RequestPathRegeneration);
+	}
+
+	GoalActor = newGoalActor;
+	RequestPathRegeneration();
+}
+
+FPathFindingQuery AATestingNavigatingActor::MakePathFindingQuery() const
+{
+	return FPathFindingQuery(this, *NavigationData, GetActorLocation(), GoalActor->GetActorLocation(), UNavigationQueryFilter::GetQueryFilter(*NavigationData, this, NavigationFilterClass), nullptr, UE_BIG_NUMBER, true);
+}
+
+TArray<FVector> AATestingNavigatingActor::SmoothPath(FNavPathSharedPtr path)
+{
+	if (FNavigationPath* navPath = path.Get())
+	{
+		RecastNavMesh = Cast<ARecastNavMesh>(NavigationData);
+
+		// Redundant really, but paranoia
+		ensure(NavSystem);
+		ensure(RecastNavMesh);
+		ensure(NavigationData);
+
+		// Flush all previous debug drawing
+		ClearDebugDrawing();
+
+		// Draw the optimal non smoothed engine path
+		DebugDrawNavigationPath(navPath->GetPathPoints(), FColor::Blue);
+
+		// Dedicated servers smooth without any debug output
+		FSmoothNavPathDebugDraw debugDraw;
+		debugDraw.World = GetWorld();
+		debugDraw.DebugStrings = DebugStringsComponent;
+		const FSmoothNavPathDebugDraw* activeDebugDraw = ShouldDebugDraw() ? &debugDraw : nullptr;
+
+		const FNavMeshPath* navMeshPath = path->CastPath<const FNavMeshPath>();
+		FSmoothNavPathLiveQueries liveQueries(*RecastNavMesh, navMeshPath ? TConstArrayView<NavNodeRef>(navMeshPath->PathCorridor) : TConstArrayView<NavNodeRef>(), activeDebugDraw, SmoothPathConfigurator.bEnableExtraDebugInfo, ExtraAgentClearance);
+
+		// Optionally record the request together with every navmesh answer, so it can be replayed offline
+		FSmoothNavReplayRecorder replayRecorder(liveQueries);
+
+		TArray<FVector> bezierSmoothedLocations;
+		FSmoothNavPathGenerator generator(replayRecorder.GetQueries(), SmoothPathConfigurator, GetSmoothingDecisions(), activeDebugDraw);
+		generator.Smooth(navPath->GetPathPoints(), SmoothPathStorage, SmoothedPath, replayRecorder.GetSamples(&bezierSmoothedLocations), &LastSmoothPathStats);
+		LastSmoothPathStats.Report();
+		SmoothPathSource = ESmoothPathSource::Smoothed;
+		++PathGeneration;
+		if(SmoothPathConfigurator.bEnableExtraDebugInfo && activeDebugDraw && !bezierSmoothedLocations.IsEmpty())
+		{
+			activeDebugDraw->DrawString(LastSmoothPathStats.ToString(), FColor::White, bezierSmoothedLocations.Last() + FVector(0,0, 100));
 		}
 
-		// Add the very last location to the final array
-		bezierSmoothedLocations.Emplace(navPathPoints.Last().Location);
+		replayRecorder.Finish(navPath->GetPathPoints(), navMeshPath ? TConstArrayView<NavNodeRef>(navMeshPath->PathCorridor) : TConstArrayView<NavNodeRef>(),
+			SmoothPathConfigurator, SmoothPathStorage, NavigationFilterClass ? NavigationFilterClass->GetPathName() : TEXT("None"), LastSmoothPathStats);
+
+		GatherCorridorNavTiles(path, SmoothedPathNavTiles);
 
 		// Debug draw the smoothed path
 		DebugDrawNavigationPath(bezierSmoothedLocations, FColor::Cyan);
@@ -242,12 +442,49 @@ TArray<FVector> AATestingNavigatingActor::SmoothPath(FNavPathSharedPtr path)
 	}
 
 	// No nav path?
+	LastSmoothPathStats.Reset();
+	SmoothedPath.Reset();
+	SmoothedPathNavTiles.Reset();
+	SmoothPathSource = ESmoothPathSource::None;
 	return {};
 }
 
+const FSmoothNavPathDecisions& AATestingNavigatingActor::GetSmoothingDecisions()
+{
+	if(USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld()))
+	{
+		return smoothNavPathSubsystem->GetSmoothingDecisions(SmoothPathConfigurator);
+	}
+
+	// Worlds without the subsystem (editor previews) build their own, it is only a small table
+	FallbackSmoothingDecisions.Build(SmoothPathConfigurator);
+	return FallbackSmoothingDecisions;
+}
+
+bool AATestingNavigatingActor::ShouldDebugDraw() const
+{
+#if ENABLE_DRAW_DEBUG
+	return bDebugDrawPath && GetWorld() && GetNetMode() != NM_DedicatedServer;
+#else
+	return false;
+#endif
+}
+
+void AATestingNavigatingActor::ClearDebugDrawing() const
+{
+	if(ShouldDebugDraw())
+	{
+		FlushPersistentDebugLines(GetWorld());
+		if(DebugStringsComponent)
+		{
+			DebugStringsComponent->ClearDebugText();
+		}
+	}
+}
+
 void AATestingNavigatingActor::DebugDrawNavigationPath(const TArray<FVector>& pathPoints, const FColor& color) const
 {
-	if (!pathPoints.IsEmpty()) 
+	if (!pathPoints.IsEmpty() && ShouldDebugDraw()) 
 	{
 		switch (NavPathDrawType)
 		{
@@ -290,104 +527,225 @@ void AATestingNavigatingActor::DebugDrawNavigationPath(const TArray<FNavPathPoin
 	DebugDrawNavigationPath(navPoints, color);
 }
 
-void AATestingNavigatingActor::GetClosestPointOnNearbyPolys(NavNodeRef originalPoly, const FVector& testPt, FVector& pointOnPoly) const
+void AATestingNavigatingActor::SchedulePredictiveSmoothing()
 {
-	ensure(RecastNavMesh);
-	
-	TArray<NavNodeRef> polyNeighbors;
-	RecastNavMesh->GetPolyNeighbors(originalPoly, polyNeighbors);
-	RecastNavMesh->GetClosestPointOnPoly(originalPoly, testPt, pointOnPoly);
-		
-	float smallestDistSq = FVector::DistSquared(testPt, pointOnPoly);
-	FVector closestPointOnNeighbor;
-	for(const NavNodeRef& neighbor : polyNeighbors)
-	{
-		RecastNavMesh->GetClosestPointOnPoly(neighbor, testPt, closestPointOnNeighbor);
-		const float distanceSqr = FVector::DistSquared(testPt, closestPointOnNeighbor);
-		if(distanceSqr < smallestDistSq)
+	UWorld* world = GetWorld();
+	USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(world);
+	if(!bPredictivePreSmoothing || CandidateGoalActors.IsEmpty() || !world || !world->IsGameWorld() || !smoothNavPathSubsystem || !NavSystem || !NavigationData || !RecastNavMesh)
+	{
+		return;
+	}
+
+	// Anything smoothed during a build would be invalidated as soon as it finishes
+	if(NavSystem->IsNavigationBuildInProgress())
+	{
+		return;
+	}
+
+	const FVector predictedLocation = GetActorLocation() + GetVelocity() * PredictionLeadTime;
+	const FSharedConstNavQueryFilter queryFilter = UNavigationQueryFilter::GetQueryFilter(*NavigationData, this, NavigationFilterClass);
+	const uint32 predictionConfigHash = GetPredictionConfigHash();
+	for(const TObjectPtr<AGoalActor>& candidateGoal : CandidateGoalActors)
+	{
+		if(!IsValid(candidateGoal) || candidateGoal == GoalActor)
 		{
-			smallestDistSq = distanceSqr;
-			pointOnPoly = closestPointOnNeighbor;
+			continue;
 		}
+
+		const FVector goalLocation = candidateGoal->GetActorLocation();
+		const uint32 predictionKey = USmoothNavPathSubsystem::MakePredictionKey(predictedLocation, goalLocation, predictionConfigHash);
+		if(!smoothNavPathSubsystem->BeginPrediction(predictionKey))
+		{
+			continue;
+		}
+
+		InFlightPredictionKeys.Emplace(predictionKey);
+		const FPathFindingQuery query(this, *NavigationData, predictedLocation, goalLocation, queryFilter, nullptr, UE_BIG_NUMBER, true);
+		NavSystem->FindPathAsync(NavigationData->GetConfig(), query, FNavPathQueryDelegate::CreateUObject(this, &AATestingNavigatingActor::OnPredictionPathFound, predictionKey, predictedLocation, goalLocation));
 	}
 }
 
-bool AATestingNavigatingActor::IsSegmentIsFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) const
+void AATestingNavigatingActor::OnPredictionPathFound(uint32 queryID, ENavigationQueryResult::Type result, FNavPathSharedPtr path, uint32 predictionKey, FVector startLocation, FVector goalLocation)
 {
-	ensure(RecastNavMesh);
-	ensure(NavigationData);
-	return !RecastNavMesh->Raycast(segmentStart, segmentEnd, hitLocation, NavigationData->GetDefaultQueryFilter());
+	InFlightPredictionKeys.RemoveSingleSwap(predictionKey);
+
+	USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld());
+	if(!smoothNavPathSubsystem)
+	{
+		return;
+	}
+
+	if(result != ENavigationQueryResult::Success || !path.IsValid() || !RecastNavMesh)
+	{
+		smoothNavPathSubsystem->CancelPrediction(predictionKey);
+		return;
+	}
+
+	// The subsystem smooths it later from copies, this actor and the engine path may change or go away before it gets to it
+	FSmoothNavPredictionRequest request;
+	request.PredictionKey = predictionKey;
+	request.PredictionGeneration = smoothNavPathSubsystem->GetPredictionGeneration();
+	request.NavMesh = RecastNavMesh.Get();
+	request.PathPoints = path->GetPathPoints();
+	if(const FNavMeshPath* navMeshPath = path->CastPath<const FNavMeshPath>())
+	{
+		request.PathCorridor = navMeshPath->PathCorridor;
+	}
+	request.Config = SmoothPathConfigurator;
+	request.Config.bEnableExtraDebugInfo = false;
+	request.Storage = SmoothPathStorage;
+	request.ExtraClearance = ExtraAgentClearance;
+	request.FilterClassName = NavigationFilterClass ? NavigationFilterClass->GetPathName() : TEXT("None");
+	request.ConfigHash = GetPredictionConfigHash();
+	request.StartLocation = startLocation;
+	request.GoalLocation = goalLocation;
+	request.NavPath = path;
+	smoothNavPathSubsystem->QueuePrediction(MoveTemp(request));
 }
 
-bool AATestingNavigatingActor::IsSegmentIsFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd) const
+bool AATestingNavigatingActor::TryUsePredictedPath()
 {
-	ensure(RecastNavMesh);
-	ensure(NavigationData);
-	FVector dummyHitLoc;
-	return !RecastNavMesh->Raycast(segmentStart, segmentEnd, dummyHitLoc, NavigationData->GetDefaultQueryFilter());
+	USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld());
+	if(!bPredictivePreSmoothing || !smoothNavPathSubsystem)
+	{
+		return false;
+	}
+
+	const FVector startLocation = GetActorLocation();
+	const FVector goalLocation = GoalActor->GetActorLocation();
+	FSmoothNavPrediction prediction;
+	if(!smoothNavPathSubsystem->ConsumePrediction(GetPredictionConfigHash(), startLocation, goalLocation, prediction))
+	{
+		return false;
+	}
+
+	SmoothedPath = MoveTemp(prediction.Path);
+	LastSmoothPathStats = prediction.Stats;
+	SmoothPathSource = ESmoothPathSource::Predicted;
+	++PathGeneration;
+	GatherCorridorNavTiles(prediction.NavPath, SmoothedPathNavTiles);
+	ObserveNavPath(prediction.NavPath);
+
+	ClearDebugDrawing();
+	DebugDrawNavigationPath(prediction.NavPath->GetPathPoints(), FColor::Blue);
+	TArray<FVector> predictedSamples;
+	SmoothedPath.DecodeSamples(predictedSamples);
+	DebugDrawNavigationPath(predictedSamples, FColor::Cyan);
+
+	// The next goal switch can be predicted from here on
+	SchedulePredictiveSmoothing();
+	return true;
 }
 
-void AATestingNavigatingActor::CalculateFirstBiasPoint(FVector& bias, const FNavPathPoint& currentPoint,const FNavPathPoint& nextPoint, FNavPathSharedPtr originalPathSharedPtr, const TArray<FVector>& smoothPathPoints) const
+uint32 AATestingNavigatingActor::GetPredictionConfigHash() const
 {
-	bias = nextPoint.Location - currentPoint.Location;
-	
-	// Sample experimental bias from actual plotted interpolated points instead if we already have some.
-	if (smoothPathPoints.Num() > 1) {
-		bias = smoothPathPoints[smoothPathPoints.Num() - 1] - smoothPathPoints[smoothPathPoints.Num() - 2];
-	}
-			
-	// We plot this bias point at (previous points direction * distance offset + current point location)
-	const float currentSegmentDistanceOffset = FVector::Dist(currentPoint.Location, nextPoint.Location) * SmoothPathConfigurator.Bias1_DistanceScalar;
-	bias.Normalize();
-	bias *= currentSegmentDistanceOffset;
-	bias += currentPoint.Location;
-
-	// Adjust the first bias in case it's outside of navmesh
-	FVector testLocBias1;
-	if(!IsSegmentIsFullyOnNavmesh(currentPoint.Location, bias, testLocBias1))
-	{
-		DebugStringsComponent->DrawDebugStringAtLocation(TEXT("SEGMENT OUT OF BOUNDS!"), FColor::Emerald, 1.5f, bias);
-		bias = testLocBias1;
-
-		// Trace from nextP to bias to check for more potential navmesh inconsistencies. If there's no valid segment from nextP to bias then we need to clamp it to whatever it can be there.
-		FVector testLocBias1Extra;
-		if(!IsSegmentIsFullyOnNavmesh(nextPoint.Location, bias, testLocBias1Extra))
-		{
-			// Tile stuff
-			GetSafeBiasLocation(bias, originalPathSharedPtr, currentPoint, nextPoint);
-		}
-	}
+	uint32 hash = GetPathConfigHash();
+	hash = HashCombine(hash, GetTypeHash(SmoothPathStorage));
+	hash = HashCombine(hash, GetTypeHash(NavigationFilterClass.Get()));
+	return hash;
 }
 
-void AATestingNavigatingActor::GetSafeBiasLocation(FVector& bias, FNavPathSharedPtr path, const FNavPathPoint& currentPoint, const FNavPathPoint& nextPoint) const
+uint32 AATestingNavigatingActor::GetPathConfigHash() const
 {
-	const FNavMeshPath* navMeshPath = path->CastPath<const FNavMeshPath>();
-	TArray<NavNodeRef> segmentPathPolys;
-	const int32 startIndex = navMeshPath->GetNodeRefIndex(currentPoint.NodeRef);
+	// A different agent type smooths against a different navmesh and clearance
+	uint32 hash = SmoothPathConfigurator.GetConfigHash();
+	hash = HashCombine(hash, GetTypeHash(NavigationData ? NavigationData->GetFName() : NAME_None));
+	hash = HashCombine(hash, GetTypeHash(ExtraAgentClearance));
+	return hash;
+}
 
-	uint32 polyID;
-	uint32 tileID;
-	RecastNavMesh->GetPolyTileIndex(currentPoint.NodeRef,polyID,tileID );
-	TArray<FNavPoly> polys;
-	RecastNavMesh->GetPolysInTile(tileID, polys);
-	const int32 endIndex = navMeshPath->GetNodeRefIndex(nextPoint.NodeRef);
-	for(int32 nodeIndex = startIndex; nodeIndex <= endIndex; nodeIndex++)
+bool AATestingNavigatingActor::TryUseBakedPath()
+{
+	bUsingBakedPath = false;
+	if(!bUseBakedPath || !BakedPath.IsBaked() || !RecastNavMesh)
 	{
-		const NavNodeRef nodeRef = navMeshPath->PathCorridor[nodeIndex];
-		segmentPathPolys.Emplace(nodeRef);
+		return false;
 	}
-	
-	for(FNavPoly& p : polys)
+
+	// The bake is only valid for the exact route and configuration it was generated with
+	constexpr float locationTolerance = 1.f;
+	if(!BakedPath.StartLocation.Equals(GetActorLocation(), locationTolerance)
+		|| !BakedPath.GoalLocation.Equals(GoalActor->GetActorLocation(), locationTolerance)
+		|| BakedPath.ConfigHash != GetPathConfigHash())
 	{
-		DrawDebugBox(GetWorld(), p.Center, FVector(30,30,30), FColor::Orange, true, -1, 0, 4.f);
+		return false;
 	}
 
-	GEngine->AddOnScreenDebugMessage(-1, 10.f, FColor::Magenta, TEXT("PASSED CONDITION?"));
-	// for(const NavNodeRef n : segmentPathPolys)
-	// {
-	// 	FVector polyCenter;
-	// 	RecastNavMesh->GetPolyCenter(n, polyCenter);
-	// 	//DrawDebugBox(GetWorld(), polyCenter, FVector(30,30,30), FColor::Orange, true, -1, 0, 4.f);
-	// }
+	// Any change to the tiles the corridor crosses requires a recompute
+	if(BakedPath.NavTilesHash != GetBakedNavTilesHash())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s: Baked smooth path is outdated, navmesh tiles changed since it was baked."), *GetName());
+		return false;
+	}
+
+	SmoothedPath = BakedPath.Path;
+	SmoothedPathNavTiles = BakedPath.NavTileIndices;
+	StopObservingNavPath();
+	bUsingBakedPath = true;
+	SmoothPathSource = ESmoothPathSource::Baked;
+	++PathGeneration;
+
+	// Flush all previous debug drawing and draw the baked path instead
+	ClearDebugDrawing();
+
+	TArray<FVector> bakedSamples;
+	SmoothedPath.DecodeSamples(bakedSamples);
+	DebugDrawNavigationPath(bakedSamples, FColor::Cyan);
+	return true;
 }
 
+void AATestingNavigatingActor::GatherCorridorNavTiles(FNavPathSharedPtr path, TArray<int32>& outTileIndices) const
+{
+	outTileIndices.Reset();
+	const FNavMeshPath* navMeshPath = path.IsValid() ? path->CastPath<const FNavMeshPath>() : nullptr;
+	if(!navMeshPath || !RecastNavMesh)
+	{
+		return;
+	}
+
+	for(const NavNodeRef nodeRef : navMeshPath->PathCorridor)
+	{
+		uint32 polyID;
+		uint32 tileID;
+		if(RecastNavMesh->GetPolyTileIndex(nodeRef, polyID, tileID))
+		{
+			outTileIndices.AddUnique(static_cast<int32>(tileID));
+		}
+	}
+}
+
+uint32 AATestingNavigatingActor::GetBakedNavTilesHash()
+{
+	if(!BakedNavTilesHashCache.IsSet() || BakedNavTilesHashNavMesh.Get() != RecastNavMesh)
+	{
+		BakedNavTilesHashCache = CalculateNavTilesHash(BakedPath.NavTileIndices);
+		BakedNavTilesHashNavMesh = RecastNavMesh.Get();
+	}
+	return BakedNavTilesHashCache.GetValue();
+}
+
+uint32 AATestingNavigatingActor::CalculateNavTilesHash(const TArray<int32>& tileIndices) const
+{
+	ensure(RecastNavMesh);
+
+	// Geometry only. Poly refs include the tile salt, which changes whenever a tile is rebuilt, even when the rebuild produced the same polys.
+	uint32 hash = GetTypeHash(tileIndices.Num());
+	TArray<FNavPoly> polys;
+	for(const int32 tileIndex : tileIndices)
+	{
+		int32 tileX = 0;
+		int32 tileY = 0;
+		int32 tileLayer = 0;
+		RecastNavMesh->GetNavMeshTileXY(tileIndex, tileX, tileY, tileLayer);
+		hash = HashCombine(hash, GetTypeHash(FIntVector(tileX, tileY, tileLayer)));
+
+		polys.Reset();
+		RecastNavMesh->GetPolysInTile(tileIndex, polys);
+		hash = HashCombine(hash, GetTypeHash(polys.Num()));
+		for(const FNavPoly& poly : polys)
+		{
+			hash = HashCombine(hash, GetTypeHash(poly.Center));
+		}
+	}
+	return hash;
+}
@@ -4,7 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
-#include "Math/UnrealMathUtility.h"
+#include "CompactSmoothPath.h"
+#include "SmoothNavPathTypes.h"
+#include "SmoothNavPathStats.h"
+#include "Containers/Ticker.h"
+#include "NavigationData.h"
 #include "ATestingNavigatingActor.generated.h"
 
 class UNavigationSystemV1;
@@ -19,96 +23,71 @@ enum class ENavPathDrawType : uint8 {
 	PointsAndLines = 2	UMETA(DisplayName = "Points And Lines"),
 };
 
-enum class EAngleUnits : uint8 {
-	Degrees = 0,
-	Radians = 1	
+// Where the current smooth path of an actor came from
+UENUM(BlueprintType)
+enum class ESmoothPathSource : uint8 {
+	None = 0	UMETA(DisplayName = "None"),
+	Smoothed = 1	UMETA(DisplayName = "Smoothed"),
+	Baked = 2	UMETA(DisplayName = "Baked"),
+	Predicted = 3	UMETA(DisplayName = "Predicted"),
 };
 
-template <typename VectorType>
-float GetAngleBetweenUnitVectors(const VectorType& a, const VectorType& b, EAngleUnits units = EAngleUnits::Radians)
-{
-	static_assert(std::is_same_v<FVector, VectorType>, "Only vector types supported");
-	
-	const float dotProduct = FVector::DotProduct(a, b);
-	const float angleInRadians = FMath::Acos(dotProduct);
-	return units == EAngleUnits::Radians ? angleInRadians : FMath::RadiansToDegrees(angleInRadians);
-}
-
-template<typename T>
-inline T GetBezierPoint(float t, T P0, T P1, T P2) {
-	float u = 1 - t;
-	float tt = t * t;
-	float uu = u * u;
-	T P = uu * P0;
-	P += 2 * u * t * P1;
-	P += tt * P2;
-	return P;
-}
-
-template<typename T>
-inline T GetCubicBezierPoint(float t, T P0, T P1, T P2, T P3) {
-	float u = 1 - t;
-	float tt = t * t;
-	float uu = u * u;
-	float uuu = uu * u;
-	float ttt = tt * t;
-	T P = uuu * P0; 
-	P += 3 * uu * t * P1; 
-	P += 3 * u * tt * P2; 
-	P += ttt * P3; 
-	return P;
-}
-
-USTRUCT(BlueprintType)
-struct FSmoothNavPathConfig
+// A smooth path baked in the editor for a static route. It is reused at runtime as long as the navmesh tiles it crosses did not change.
+USTRUCT()
+struct FBakedSmoothPath
 {
 	GENERATED_BODY()
 
-	// How far along the direction vector will the first bias point be offset (resulting distance = full distance * Bias1_DistanceScalar)
-	UPROPERTY(EditAnywhere, Category="First Bias", meta=(ClampMin=0.1, ClampMax=1.f, UIMin = 0.1, UIMax = 1.f))
-	float Bias1_DistanceScalar = 0.5f;
-
-	// Max distance of how far along the direction vector will the second bias point be offset
-	UPROPERTY(EditAnywhere, Category="Second Bias", meta=(ClampMin=0.0, UIMin = 0.0, UIMax = 1000.f))
-	float Bias2_MaxDistanceOffset = 500.f;
+	UPROPERTY()
+	FCompactSmoothPath Path;
 
-	// Min distance of how far along the direction vector will the second bias point be offset
-	UPROPERTY(EditAnywhere, Category="Second Bias", meta=(ClampMin=0.0, UIMin = 0.0, UIMax = 300.f))
-	float Bias2_MinDistanceOffset = 50.f;
+	// Tiles crossed by the path corridor at bake time, and the hash of their polygons
+	UPROPERTY()
+	TArray<int32> NavTileIndices;
 
-	// A configurable threshold for when the smooth path should attempt to skip certain nav points to maintain a smoother integrity (VERY EXPERIMENTAL)
-	UPROPERTY(EditAnywhere, Category="Nav Point Skipping", meta=(InlineEditConditionToggle))
-	bool bNavPointSkipping = true;
+	UPROPERTY()
+	uint32 NavTilesHash = 0;
 
-	// A configurable threshold for when the smooth path should attempt to skip certain nav points to maintain a smoother integrity (VERY EXPERIMENTAL)
-	UPROPERTY(EditAnywhere, Category="Nav Point Skipping", meta=(EditCondition="bNavPointSkipping", ClampMin=0.f, UIMin = 0.f, UIMax = 90.f))
-	float MinAngleSkipThreshold = 20.f;
+	// Inputs the path was baked for
+	UPROPERTY()
+	FVector StartLocation = FVector::ZeroVector;
 
-	// A small offset to apply to next point in order to smooth out the turns more and avoid some inconsistencies
-	UPROPERTY(EditAnywhere, meta=(ClampMin=0.f, UIMin = 0.f, UIMax = 100.f))
-	float NextPointOffset = 50.0f;
+	UPROPERTY()
+	FVector GoalLocation = FVector::ZeroVector;
 
-	// Return to default smooth path config values
-	UPROPERTY(EditAnywhere)
-	bool bResetToDefaultConfigValues = false;
+	UPROPERTY()
+	uint32 ConfigHash = 0;
 
-	// Extra debugging information. For now I am just toggling everything, but it's going to be separated out in the future
-	UPROPERTY(EditAnywhere, Category="Debugging")
-	bool bEnableExtraDebugInfo = false;
+	bool IsBaked() const { return !Path.IsEmpty(); }
 
-	void ResetToDefaults()
+	void Reset()
 	{
-		Bias1_DistanceScalar = 0.5f;
-		Bias2_MaxDistanceOffset = 500.f;
-		Bias2_MinDistanceOffset = 50.f;
-		bNavPointSkipping = true;
-		MinAngleSkipThreshold = 20.f;
-		NextPointOffset = 50.0f;
-		bResetToDefaultConfigValues = false;
-		bEnableExtraDebugInfo = false;
+		Path.Reset();
+		NavTileIndices.Empty();
+		NavTilesHash = 0;
+		StartLocation = FVector::ZeroVector;
+		GoalLocation = FVector::ZeroVector;
+		ConfigHash = 0;
 	}
 };
 
+// Result of evaluating one candidate goal of a multi-goal query
+USTRUCT(BlueprintType)
+struct FSmoothPathGoalCandidate
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Smooth Path")
+	TObjectPtr<AGoalActor> GoalActor = nullptr;
+
+	// Pathfinding cost from the source to the goal, as found by the shared graph exploration
+	UPROPERTY(BlueprintReadOnly, Category="Smooth Path")
+	float PathCost = UE_BIG_NUMBER;
+
+	UPROPERTY(BlueprintReadOnly, Category="Smooth Path")
+	bool bReachable = false;
+};
+
 UCLASS()
 class SMOOTHNAVIGATIONTEST_API AATestingNavigatingActor : public AActor
 {
@@ -130,45 +109,191 @@ public:
 	UPROPERTY(EditAnywhere, Category="Smooth Path")
 	bool bRecalculateSmoothPath = false;
 
+	// Possible destinations evaluated together by a multi-goal query. Only the winning goal gets smoothed.
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Multi Goal")
+	TArray<TObjectPtr<AGoalActor>> CandidateGoalActors;
+
+	// How far along the navmesh the multi-goal query explores from this actor. Candidates further away are treated as unreachable.
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Multi Goal", meta=(ClampMin=0.f, UIMin = 0.f, UIMax = 50000.f))
+	float CandidateSearchDistance = 10000.f;
+
+	// In game worlds, smooth the paths to the other candidate goals ahead of time so switching to one of them completes right away.
+	// The smoothing runs on the game thread within smoothnav.Prediction.BudgetMs per frame, not on a worker thread, so predicting still costs frame time.
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Multi Goal")
+	bool bPredictivePreSmoothing = true;
+
+	// How far ahead (in seconds) the start of the predicted paths is extrapolated from the current velocity
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Multi Goal", meta=(EditCondition="bPredictivePreSmoothing", ClampMin=0.f, UIMin = 0.f, UIMax = 2.f))
+	float PredictionLeadTime = 0.25f;
+
 	UPROPERTY(EditAnywhere, Category="Smooth Path|Debug")
 	ENavPathDrawType NavPathDrawType = ENavPathDrawType::Points;
 
+	// Draw the raw and smoothed paths. Off for crowds, where persistent debug lines would dominate the cost.
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Debug")
+	bool bDebugDrawPath = true;
+
 	UPROPERTY(EditAnywhere, Category="Smooth Path")
 	FSmoothNavPathConfig SmoothPathConfigurator;
 
+	// How the generated smooth path is kept in memory. Quantized modes only store the curve control points relative to the path bounds
+	UPROPERTY(EditAnywhere, Category="Smooth Path")
+	ESmoothPathStorage SmoothPathStorage = ESmoothPathStorage::Int16;
+
+	// Editor changes are coalesced and only regenerate the path once no new change arrived for this long (in seconds)
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Editor", meta=(ClampMin=0.f, UIMin = 0.f, UIMax = 1.f))
+	float EditorRegenerationDebounce = 0.05f;
+
+	// Reuse the baked smooth path while it is still valid for the navmesh, skipping pathfinding and smoothing entirely
+	UPROPERTY(EditAnywhere, Category="Smooth Path|Bake")
+	bool bUseBakedPath = true;
+
+	// Agent the path is generated for. Selects the navigation data of the matching agent type, invalid properties use the default navigation data.
+	UPROPERTY(EditAnywhere, Category = Pathfinding)
+	FNavAgentProperties AgentProperties;
+
 	/** "None" will result in default filter being used */
 	UPROPERTY(EditAnywhere, Category = Pathfinding)
 	TSubclassOf<UNavigationQueryFilter> NavigationFilterClass;
 
+	// Quality and cost of the last generated smooth path, for tuning SmoothPathConfigurator. Also aggregated by "stat SmoothNav" and the SmoothNav csv category.
+	UPROPERTY(VisibleAnywhere, Transient, Category="Smooth Path|Stats")
+	FSmoothNavPathStats LastSmoothPathStats;
+
+	const FCompactSmoothPath& GetSmoothedPath() const { return SmoothedPath; }
+
+	// Source of the current smooth path. LastSmoothPathStats only belong to it when it was Smoothed, a Predicted path carries the stats of its earlier smoothing.
+	ESmoothPathSource GetSmoothPathSource() const { return SmoothPathSource; }
+
+	// Incremented every time a new smooth path is set, whatever its source
+	uint32 GetPathGeneration() const { return PathGeneration; }
+
+	// Switch to another goal and regenerate the path to it
+	UFUNCTION(BlueprintCallable, Category="Smooth Path")
+	void SetGoalActor(AGoalActor* newGoalActor);
+
+	// Explore the navmesh once from this actor and rate every candidate goal by its path cost. Results are sorted, cheapest first.
+	UFUNCTION(BlueprintCallable, Category="Smooth Path|Multi Goal")
+	bool EvaluateCandidateGoals(TArray<FSmoothPathGoalCandidate>& outCandidates);
+
+	// Evaluate the candidates, make the cheapest reachable one the GoalActor and smooth the path to it
+	UFUNCTION(BlueprintCallable, CallInEditor, Category="Smooth Path|Multi Goal")
+	void SelectBestCandidateGoal();
+
 protected:
 
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	// Generate the smooth path from scratch and store it, together with the hash of the navmesh tiles it crosses, in this actor
+	UFUNCTION(CallInEditor, Category="Smooth Path|Bake")
+	void BakeSmoothPath();
+
+	UFUNCTION(CallInEditor, Category="Smooth Path|Bake")
+	void ClearBakedSmoothPath();
 #endif
 
 	virtual void OnConstruction(const FTransform& Transform) override;
+	virtual void BeginDestroy() override;
 
 	UFUNCTION()
 	void GeneratePath();
+
+	// Mark the path as dirty. Outside of game worlds the regeneration is debounced, coalesced and the pathfinding runs asynchronously.
+	UFUNCTION()
+	void RequestPathRegeneration();
 	
+	// Runs the shared smoothing (FSmoothNavPathGenerator) against the live navmesh and debug draws the result
 	TArray<FVector> SmoothPath(FNavPathSharedPtr path);
 
+	// Decision thresholds for the current config, shared through the subsystem with every path smoothed with the same config.
+	// Only valid until the next call.
+	const FSmoothNavPathDecisions& GetSmoothingDecisions();
+
+	// Debug output is skipped on dedicated servers and in builds without debug drawing
+	bool ShouldDebugDraw() const;
+	void ClearDebugDrawing() const;
+
 	// Simple debug draw for the generated path
 	void DebugDrawNavigationPath(const TArray<FVector>& pathPoints, const FColor& color) const;
 	void DebugDrawNavigationPath(const TArray<FNavPathPoint>& pathPoints, const FColor& color) const;
 
-	// Custom helper functions
-	void GetClosestPointOnNearbyPolys(NavNodeRef originalPoly, const FVector& testPt, FVector& pointOnPoly) const;
-	bool IsSegmentIsFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) const;
-	bool IsSegmentIsFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd) const;
-	void CalculateFirstBiasPoint(FVector& bias, const FNavPathPoint& currentPoint, const FNavPathPoint& nextPoint, FNavPathSharedPtr originalPathSharedPtr, const TArray<FVector>& smoothPathPoints) const;
-	void GetSafeBiasLocation(FVector& bias, FNavPathSharedPtr path, const FNavPathPoint& currentPoint, const FNavPathPoint& nextPoint) const;
+	// Shared setup of the sync and async generation. Returns false when there is no pathfinding to be done.
+	bool ResolveNavigationData();
+	bool PreparePathGeneration();
+	FPathFindingQuery MakePathFindingQuery() const;
+
+	// Deferred regeneration
+	bool TickPendingPathRegeneration(float deltaTime);
+	void GeneratePathAsync();
+	void OnAsyncPathFound(uint32 queryID, ENavigationQueryResult::Type result, FNavPathSharedPtr path);
+
+	// Navmesh change handling. The engine keeps track of which active paths cross the rebuilt tiles and repaths only those, we only need to resmooth them.
+	void ObserveNavPath(FNavPathSharedPtr path);
+	void StopObservingNavPath();
+	void OnObservedNavPathEvent(FNavigationPath* path, ENavPathEvent::Type event);
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* navData);
+
+	// Predictive pre-smoothing. Pathfinding runs as regular async queries, the smoothing is queued on the subsystem and time sliced on the game thread.
+	void SchedulePredictiveSmoothing();
+	void OnPredictionPathFound(uint32 queryID, ENavigationQueryResult::Type result, FNavPathSharedPtr path, uint32 predictionKey, FVector startLocation, FVector goalLocation);
+	bool TryUsePredictedPath();
+	uint32 GetPredictionConfigHash() const;
+
+	// Baked path helpers
+	uint32 GetPathConfigHash() const;
+	bool TryUseBakedPath();
+	void GatherCorridorNavTiles(FNavPathSharedPtr path, TArray<int32>& outTileIndices) const;
+	uint32 CalculateNavTilesHash(const TArray<int32>& tileIndices) const;
+
+	// Current tile hash of the baked path tiles. Only recomputed once the navmesh finished rebuilding tiles, or when the bake or the navmesh changed.
+	uint32 GetBakedNavTilesHash();
 	
 private:
 
+	// Last generated smooth path. Samples are decoded from it on demand
+	UPROPERTY(Transient)
+	FCompactSmoothPath SmoothedPath;
+
+	// Navmesh tiles crossed by the corridor of the last generated path
+	TArray<int32> SmoothedPathNavTiles;
+
+	ESmoothPathSource SmoothPathSource = ESmoothPathSource::None;
+	uint32 PathGeneration = 0;
+
+	UPROPERTY()
+	FBakedSmoothPath BakedPath;
+
+	// Cache of GetBakedNavTilesHash and the navmesh it was calculated on
+	TOptional<uint32> BakedNavTilesHashCache;
+	TWeakObjectPtr<const ARecastNavMesh> BakedNavTilesHashNavMesh;
+
+	// Only used when the world has no USmoothNavPathSubsystem
+	FSmoothNavPathDecisions FallbackSmoothingDecisions;
+
+	// Pending debounced regeneration
+	FTSTicker::FDelegateHandle PathRegenerationTickerHandle;
+	double PathRegenerationDeadline = 0.0;
+
+	// Only the result of the most recent async query is used, older ones are stale
+	uint32 PendingPathQueryID = INVALID_NAVQUERYID;
+
+	// Predictions reserved on the subsystem whose pathfinding has not called back yet
+	TArray<uint32> InFlightPredictionKeys;
+
+	// Engine path backing the current smooth path. Holding it keeps it registered as an active path of the navigation data.
+	FNavPathSharedPtr ObservedNavPath;
+	FDelegateHandle ObservedNavPathHandle;
+	bool bUsingBakedPath = false;
+
 	UPROPERTY()
 	TObjectPtr<ANavigationData> NavigationData = nullptr;
 
+	// Clearance the agent needs on top of the erosion of NavigationData
+	float ExtraAgentClearance = 0.f;
+
 	UPROPERTY()
 	TObjectPtr<UNavigationSystemV1> NavSystem = nullptr;
 
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CompactSmoothPath.h"
+#include "SmoothNavPathTypes.h"
+
+void FCompactSmoothPath::Encode(const TArray<FVector>& ControlPoints, const TArray<bool>& CubicFlags, const FVector& InEndLocation, ESmoothPathStorage InStorage)
+{
+	check(ControlPoints.Num() == CubicFlags.Num() * ControlPointsPerSegment);
+
+	Reset();
+	Storage = InStorage;
+	EndLocation = InEndLocation;
+
+	SegmentFlags.Reserve(CubicFlags.Num());
+	for(const bool bCubic : CubicFlags)
+	{
+		SegmentFlags.Emplace(bCubic ? SegmentFlag_Cubic : 0);
+	}
+
+	FBox bounds(ForceInit);
+	for(const FVector& controlPoint : ControlPoints)
+	{
+		bounds += controlPoint;
+	}
+	bounds += EndLocation;
+	bounds.GetCenterAndExtents(BoundsOrigin, BoundsExtent);
+
+	switch (Storage)
+	{
+	case ESmoothPathStorage::Full:
+		{
+			FullControlPoints = ControlPoints;
+		}
+		break;
+
+	case ESmoothPathStorage::Float:
+		{
+			FloatControlPoints.Reserve(ControlPoints.Num());
+			for(const FVector& controlPoint : ControlPoints)
+			{
+				FloatControlPoints.Emplace(FVector3f(controlPoint - BoundsOrigin));
+			}
+		}
+		break;
+
+	case ESmoothPathStorage::Int16:
+		{
+			// Avoid division by zero for axis aligned paths
+			BoundsExtent = BoundsExtent.ComponentMax(FVector(UE_KINDA_SMALL_NUMBER));
+
+			Int16ControlPoints.Reserve(ControlPoints.Num() * 3);
+			for(const FVector& controlPoint : ControlPoints)
+			{
+				const FVector normalized = (controlPoint - BoundsOrigin) / BoundsExtent;
+				Int16ControlPoints.Emplace(static_cast<int16>(FMath::RoundToInt(FMath::Clamp(normalized.X, -1.0, 1.0) * MAX_int16)));
+				Int16ControlPoints.Emplace(static_cast<int16>(FMath::RoundToInt(FMath::Clamp(normalized.Y, -1.0, 1.0) * MAX_int16)));
+				Int16ControlPoints.Emplace(static_cast<int16>(FMath::RoundToInt(FMath::Clamp(normalized.Z, -1.0, 1.0) * MAX_int16)));
+			}
+		}
+		break;
+	}
+}
+
+void FCompactSmoothPath::Reset()
+{
+	BoundsOrigin = FVector::ZeroVector;
+	BoundsExtent = FVector::ZeroVector;
+	EndLocation = FVector::ZeroVector;
+	SegmentFlags.Empty();
+	FullControlPoints.Empty();
+	FloatControlPoints.Empty();
+	Int16ControlPoints.Empty();
+}
+
+int32 FCompactSmoothPath::NumSamples() const
+{
+	return IsEmpty() ? 0 : NumSegments() * GetSamplesPerSegment() + 1;
+}
+
+FVector FCompactSmoothPath::GetSample(int32 SampleIndex) const
+{
+	check(SampleIndex >= 0 && SampleIndex < NumSamples());
+
+	const int32 samplesPerSegment = GetSamplesPerSegment();
+	const int32 segmentIndex = SampleIndex / samplesPerSegment;
+	if(segmentIndex == NumSegments())
+	{
+		return EndLocation;
+	}
+
+	// Accumulate t the same way the smoothing loop does so the decoded sample is identical to the one that was produced
+	float t = 0.f;
+	for(int32 i = 0; i < SampleIndex % samplesPerSegment; i++)
+	{
+		t += SampleStep;
+	}
+	return EvaluateSegment(segmentIndex, t);
+}
+
+void FCompactSmoothPath::DecodeSamples(TArray<FVector>& OutSamples) const
+{
+	OutSamples.Reset(NumSamples());
+	if(IsEmpty())
+	{
+		return;
+	}
+
+	for(int32 segmentIndex = 0; segmentIndex < NumSegments(); segmentIndex++)
+	{
+		// Decode the control points once per segment rather than once per sample
+		const int32 baseIndex = segmentIndex * ControlPointsPerSegment;
+		const FVector p0 = GetControlPoint(baseIndex);
+		const FVector p1 = GetControlPoint(baseIndex + 1);
+		const FVector p2 = GetControlPoint(baseIndex + 2);
+		const FVector p3 = GetControlPoint(baseIndex + 3);
+		const bool bCubic = IsSegmentCubic(segmentIndex);
+
+		for (float t = 0.0; t <= 1.0; t += SampleStep) {
+			OutSamples.Emplace(bCubic ? GetCubicBezierPoint(t, p0, p1, p2, p3) : GetBezierPoint(t, p0, p1, p3));
+		}
+	}
+	OutSamples.Emplace(EndLocation);
+}
+
+FVector FCompactSmoothPath::GetControlPoint(int32 ControlPointIndex) const
+{
+	switch (Storage)
+	{
+	case ESmoothPathStorage::Float:
+		return FVector(FloatControlPoints[ControlPointIndex]) + BoundsOrigin;
+
+	case ESmoothPathStorage::Int16:
+		{
+			const int32 baseIndex = ControlPointIndex * 3;
+			const FVector normalized(
+				static_cast<double>(Int16ControlPoints[baseIndex]) / MAX_int16,
+				static_cast<double>(Int16ControlPoints[baseIndex + 1]) / MAX_int16,
+				static_cast<double>(Int16ControlPoints[baseIndex + 2]) / MAX_int16);
+			return normalized * BoundsExtent + BoundsOrigin;
+		}
+
+	case ESmoothPathStorage::Full:
+	default:
+		return FullControlPoints[ControlPointIndex];
+	}
+}
+
+SIZE_T FCompactSmoothPath::GetAllocatedSize() const
+{
+	return sizeof(FCompactSmoothPath) + SegmentFlags.GetAllocatedSize() + FullControlPoints.GetAllocatedSize() + FloatControlPoints.GetAllocatedSize() + Int16ControlPoints.GetAllocatedSize();
+}
+
+int32 FCompactSmoothPath::GetSamplesPerSegment()
+{
+	// Float accumulation decides whether t = 1 is reached, so count the samples exactly as the smoothing loop generates them
+	static const int32 samplesPerSegment = []()
+	{
+		int32 count = 0;
+		for (float t = 0.0; t <= 1.0; t += SampleStep) {
+			++count;
+		}
+		return count;
+	}();
+	return samplesPerSegment;
+}
+
+FVector FCompactSmoothPath::EvaluateSegment(int32 SegmentIndex, float T) const
+{
+	const int32 baseIndex = SegmentIndex * ControlPointsPerSegment;
+	const FVector p0 = GetControlPoint(baseIndex);
+	const FVector p1 = GetControlPoint(baseIndex + 1);
+	const FVector p3 = GetControlPoint(baseIndex + 3);
+
+	return IsSegmentCubic(SegmentIndex) ? GetCubicBezierPoint(T, p0, p1, GetControlPoint(baseIndex + 2), p3) : GetBezierPoint(T, p0, p1, p3);
+}
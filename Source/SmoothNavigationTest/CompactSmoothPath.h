@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CompactSmoothPath.generated.h"
+
+UENUM(BlueprintType)
+enum class ESmoothPathStorage : uint8 {
+	Full = 0	UMETA(DisplayName = "Full Precision"),
+	Float = 1	UMETA(DisplayName = "Quantized Float"),
+	Int16 = 2	UMETA(DisplayName = "Quantized Int16"),
+};
+
+// Compact storage for a smoothed path. Instead of keeping every interpolated sample, only the bezier control points of each segment are kept
+// (optionally quantized relative to the path bounds) and the samples are decoded on demand.
+USTRUCT()
+struct FCompactSmoothPath
+{
+	GENERATED_BODY()
+
+	// Every segment stores exactly this many control points. Quadratic segments repeat their bias point and are flagged as such.
+	static constexpr int32 ControlPointsPerSegment = 4;
+
+	// Interpolation step used when sampling each segment. Kept in sync with the smoothing loop so decoded samples match what it produced.
+	static constexpr float SampleStep = 0.1f;
+
+	// Encode the control points gathered while smoothing. ControlPoints holds ControlPointsPerSegment entries per segment, CubicFlags one entry per segment.
+	void Encode(const TArray<FVector>& ControlPoints, const TArray<bool>& CubicFlags, const FVector& InEndLocation, ESmoothPathStorage InStorage);
+	void Reset();
+
+	bool IsEmpty() const { return SegmentFlags.IsEmpty(); }
+	int32 NumSegments() const { return SegmentFlags.Num(); }
+	ESmoothPathStorage GetStorage() const { return Storage; }
+	const FVector& GetEndLocation() const { return EndLocation; }
+
+	// Number of samples the decoded path contains, including the final end location
+	int32 NumSamples() const;
+
+	// Lazily decode a single sample without expanding the whole path
+	FVector GetSample(int32 SampleIndex) const;
+
+	// Decode the full sampled path. Only meant for consumers which actually need every sample (debug drawing, path following, etc.)
+	void DecodeSamples(TArray<FVector>& OutSamples) const;
+
+	FVector GetControlPoint(int32 ControlPointIndex) const;
+	bool IsSegmentCubic(int32 SegmentIndex) const { return (SegmentFlags[SegmentIndex] & SegmentFlag_Cubic) != 0; }
+
+	// Memory of this path, the struct itself plus its heap allocations, for comparing the storage modes
+	SIZE_T GetAllocatedSize() const;
+
+	// Number of samples produced per segment by the smoothing loop
+	static int32 GetSamplesPerSegment();
+
+private:
+
+	static constexpr uint8 SegmentFlag_Cubic = 1 << 0;
+
+	FVector EvaluateSegment(int32 SegmentIndex, float T) const;
+
+	UPROPERTY()
+	ESmoothPathStorage Storage = ESmoothPathStorage::Full;
+
+	// Quantization frame. Quantized control points are stored relative to the bounds center and, for int16, normalized by the bounds extent.
+	UPROPERTY()
+	FVector BoundsOrigin = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector BoundsExtent = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector EndLocation = FVector::ZeroVector;
+
+	UPROPERTY()
+	TArray<uint8> SegmentFlags;
+
+	// Only one of these is populated, depending on Storage
+	UPROPERTY()
+	TArray<FVector> FullControlPoints;
+
+	UPROPERTY()
+	TArray<FVector3f> FloatControlPoints;
+
+	UPROPERTY()
+	TArray<int16> Int16ControlPoints;
+};
@@ -0,0 +1,335 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NavPolyCache.h"
+#include "NavMesh/RecastNavMesh.h"
+
+void FNavCorridorPolyCache::Build(const ARecastNavMesh& navMesh, TConstArrayView<NavNodeRef> corridor)
+{
+	Reset();
+
+	PolyIndexByRef.Reserve(corridor.Num() * 4);
+	CorridorIndexByRef.Reserve(corridor.Num());
+	for(int32 corridorIndex = 0; corridorIndex < corridor.Num(); corridorIndex++)
+	{
+		// Keep the first occurrence, like GetNodeRefIndex does
+		if(!CorridorIndexByRef.Contains(corridor[corridorIndex]))
+		{
+			CorridorIndexByRef.Add(corridor[corridorIndex], corridorIndex);
+		}
+	}
+
+	TArray<FVector> vertsScratch;
+	TArray<NavNodeRef> neighborsScratch;
+
+	// Corridor polys first, so their indices are stable while neighbors get appended
+	for(const NavNodeRef polyRef : corridor)
+	{
+		AddPoly(navMesh, polyRef, vertsScratch);
+	}
+
+	const int32 numCorridorPolys = PolyRefs.Num();
+	PolyNeighborStart.SetNumZeroed(numCorridorPolys);
+	PolyNeighborCount.SetNumZeroed(numCorridorPolys);
+	for(int32 polyIndex = 0; polyIndex < numCorridorPolys; polyIndex++)
+	{
+		neighborsScratch.Reset();
+		navMesh.GetPolyNeighbors(PolyRefs[polyIndex], neighborsScratch);
+
+		PolyNeighborStart[polyIndex] = NeighborPolyIndices.Num();
+		for(const NavNodeRef neighborRef : neighborsScratch)
+		{
+			const int32 neighborIndex = AddPoly(navMesh, neighborRef, vertsScratch);
+			if(neighborIndex != INDEX_NONE)
+			{
+				NeighborPolyIndices.Emplace(neighborIndex);
+			}
+		}
+		PolyNeighborCount[polyIndex] = NeighborPolyIndices.Num() - PolyNeighborStart[polyIndex];
+	}
+
+	// Neighbor-only polys have no links of their own
+	PolyNeighborStart.SetNumZeroed(PolyRefs.Num());
+	PolyNeighborCount.SetNumZeroed(PolyRefs.Num());
+}
+
+void FNavCorridorPolyCache::Reset()
+{
+	PolyRefs.Reset();
+	PolyVertStart.Reset();
+	PolyVertCount.Reset();
+	PolyNeighborStart.Reset();
+	PolyNeighborCount.Reset();
+	NeighborPolyIndices.Reset();
+	VertX.Reset();
+	VertY.Reset();
+	VertZ.Reset();
+	PolyIndexByRef.Reset();
+	CorridorIndexByRef.Reset();
+}
+
+int32 FNavCorridorPolyCache::FindPolyIndex(NavNodeRef polyRef) const
+{
+	const int32* polyIndex = PolyIndexByRef.Find(polyRef);
+	return polyIndex ? *polyIndex : INDEX_NONE;
+}
+
+int32 FNavCorridorPolyCache::FindCorridorIndex(NavNodeRef polyRef) const
+{
+	const int32* corridorIndex = CorridorIndexByRef.Find(polyRef);
+	return corridorIndex ? *corridorIndex : INDEX_NONE;
+}
+
+void FNavCorridorPolyCache::GetClosestPointOnPoly(int32 polyIndex, const FVector& testPt, FVector& pointOnPoly) const
+{
+	const int32 vertStart = PolyVertStart[polyIndex];
+	const int32 vertCount = PolyVertCount[polyIndex];
+	check(vertCount >= 3);
+
+	if(IsPointInPoly2D(polyIndex, testPt))
+	{
+		// Inside: keep the 2D location and take the height from the triangle fan of the poly
+		pointOnPoly = testPt;
+		const FVector::FReal px = testPt.X;
+		const FVector::FReal py = testPt.Y;
+		const int32 v0 = vertStart;
+		for(int32 i = 1; i + 1 < vertCount; i++)
+		{
+			const int32 v1 = vertStart + i;
+			const int32 v2 = vertStart + i + 1;
+			const FVector::FReal denom = (VertY[v1] - VertY[v2]) * (VertX[v0] - VertX[v2]) + (VertX[v2] - VertX[v1]) * (VertY[v0] - VertY[v2]);
+			if(FMath::IsNearlyZero(denom))
+			{
+				continue;
+			}
+
+			const FVector::FReal a = ((VertY[v1] - VertY[v2]) * (px - VertX[v2]) + (VertX[v2] - VertX[v1]) * (py - VertY[v2])) / denom;
+			const FVector::FReal b = ((VertY[v2] - VertY[v0]) * (px - VertX[v2]) + (VertX[v0] - VertX[v2]) * (py - VertY[v2])) / denom;
+			const FVector::FReal c = 1.0 - a - b;
+			constexpr FVector::FReal epsilon = -UE_KINDA_SMALL_NUMBER;
+			if(a >= epsilon && b >= epsilon && c >= epsilon)
+			{
+				pointOnPoly.Z = a * VertZ[v0] + b * VertZ[v1] + c * VertZ[v2];
+				return;
+			}
+		}
+		pointOnPoly.Z = VertZ[v0];
+		return;
+	}
+
+	// Outside: closest point on the boundary edges, measured in 2D like detour does
+	FVector::FReal smallestDistSq = UE_BIG_NUMBER;
+	for(int32 i = 0, j = vertCount - 1; i < vertCount; j = i++)
+	{
+		const int32 va = vertStart + j;
+		const int32 vb = vertStart + i;
+		const FVector::FReal edgeX = VertX[vb] - VertX[va];
+		const FVector::FReal edgeY = VertY[vb] - VertY[va];
+		const FVector::FReal edgeLenSq = edgeX * edgeX + edgeY * edgeY;
+		FVector::FReal t = edgeLenSq > UE_SMALL_NUMBER ? ((testPt.X - VertX[va]) * edgeX + (testPt.Y - VertY[va]) * edgeY) / edgeLenSq : 0.0;
+		t = FMath::Clamp(t, 0.0, 1.0);
+
+		const FVector::FReal closestX = VertX[va] + edgeX * t;
+		const FVector::FReal closestY = VertY[va] + edgeY * t;
+		const FVector::FReal distSq = FMath::Square(testPt.X - closestX) + FMath::Square(testPt.Y - closestY);
+		if(distSq < smallestDistSq)
+		{
+			smallestDistSq = distSq;
+			pointOnPoly = FVector(closestX, closestY, FMath::Lerp(VertZ[va], VertZ[vb], t));
+		}
+	}
+}
+
+FVector FNavCorridorPolyCache::GetPolyCenter(int32 polyIndex) const
+{
+	const int32 vertStart = PolyVertStart[polyIndex];
+	const int32 vertCount = PolyVertCount[polyIndex];
+	FVector center = FVector::ZeroVector;
+	for(int32 vertIndex = vertStart; vertIndex < vertStart + vertCount; vertIndex++)
+	{
+		center += GetVertex(vertIndex);
+	}
+	return center / vertCount;
+}
+
+bool FNavCorridorPolyCache::IsPointInPoly2D(int32 polyIndex, const FVector& testPt) const
+{
+	// Crossing test, the same one detour uses in dtPointInPolygon
+	const int32 vertStart = PolyVertStart[polyIndex];
+	const int32 vertCount = PolyVertCount[polyIndex];
+	bool bInside = false;
+	for(int32 i = 0, j = vertCount - 1; i < vertCount; j = i++)
+	{
+		const int32 vi = vertStart + i;
+		const int32 vj = vertStart + j;
+		if(((VertY[vi] > testPt.Y) != (VertY[vj] > testPt.Y))
+			&& (testPt.X < (VertX[vj] - VertX[vi]) * (testPt.Y - VertY[vi]) / (VertY[vj] - VertY[vi]) + VertX[vi]))
+		{
+			bInside = !bInside;
+		}
+	}
+	return bInside;
+}
+
+bool FNavCorridorPolyCache::RaycastLocal(NavNodeRef startPoly, const FVector& segmentStart, const FVector& segmentEnd, bool& bOutHit, FVector& outHitLocation, FVector& outHitNormal) const
+{
+	int32 polyIndex = FindPolyIndex(startPoly);
+	if(polyIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Path corners sit on poly vertices, so a start nudged off the corner may already be inside one of the neighbors
+	if(!IsPointInPoly2D(polyIndex, segmentStart))
+	{
+		int32 containingIndex = INDEX_NONE;
+		const int32 neighborEnd = PolyNeighborStart[polyIndex] + PolyNeighborCount[polyIndex];
+		for(int32 i = PolyNeighborStart[polyIndex]; i < neighborEnd; i++)
+		{
+			if(IsPointInPoly2D(NeighborPolyIndices[i], segmentStart))
+			{
+				if(containingIndex != INDEX_NONE)
+				{
+					return false;
+				}
+				containingIndex = NeighborPolyIndices[i];
+			}
+		}
+
+		if(containingIndex == INDEX_NONE)
+		{
+			return false;
+		}
+		polyIndex = containingIndex;
+	}
+
+	const FVector::FReal dirX = segmentEnd.X - segmentStart.X;
+	const FVector::FReal dirY = segmentEnd.Y - segmentStart.Y;
+	constexpr int32 maxWalkedPolys = 32;
+	constexpr FVector::FReal edgeParamTolerance = 1.e-3;
+
+	// Crossings this close to a vertex (in cm) could continue into any of the polys sharing it
+	constexpr FVector::FReal vertexClearanceSq = 4.0;
+	FVector::FReal enterT = 0.0;
+	for(int32 walkedPolys = 0; walkedPolys < maxWalkedPolys; walkedPolys++)
+	{
+		// Closest edge crossing ahead of where the segment entered this poly. Without one the segment ends inside it.
+		const int32 vertStart = PolyVertStart[polyIndex];
+		const int32 vertCount = PolyVertCount[polyIndex];
+		FVector::FReal exitT = UE_BIG_NUMBER;
+		int32 exitEdgeStart = INDEX_NONE;
+		int32 exitEdgeEnd = INDEX_NONE;
+		for(int32 i = 0, j = vertCount - 1; i < vertCount; j = i++)
+		{
+			const int32 va = vertStart + j;
+			const int32 vb = vertStart + i;
+			const FVector::FReal edgeX = VertX[vb] - VertX[va];
+			const FVector::FReal edgeY = VertY[vb] - VertY[va];
+			const FVector::FReal denom = dirX * edgeY - dirY * edgeX;
+			if(FMath::IsNearlyZero(denom))
+			{
+				continue;
+			}
+
+			const FVector::FReal toEdgeX = VertX[va] - segmentStart.X;
+			const FVector::FReal toEdgeY = VertY[va] - segmentStart.Y;
+			const FVector::FReal t = (toEdgeX * edgeY - toEdgeY * edgeX) / denom;
+			const FVector::FReal u = (toEdgeX * dirY - toEdgeY * dirX) / denom;
+			if(t > enterT + UE_KINDA_SMALL_NUMBER && t < exitT && u >= -edgeParamTolerance && u <= 1.0 + edgeParamTolerance)
+			{
+				exitT = t;
+				exitEdgeStart = va;
+				exitEdgeEnd = vb;
+			}
+		}
+
+		if(exitT > 1.0)
+		{
+			bOutHit = false;
+			outHitLocation = segmentEnd;
+			outHitNormal = FVector::ZeroVector;
+			return true;
+		}
+
+		// Only corridor polys have their neighbors cached
+		if(PolyNeighborCount[polyIndex] == 0)
+		{
+			return false;
+		}
+
+		const FVector exitPoint = FMath::Lerp(segmentStart, segmentEnd, exitT);
+		if(FVector2D::DistSquared(FVector2D(exitPoint), FVector2D(VertX[exitEdgeStart], VertY[exitEdgeStart])) <= vertexClearanceSq
+			|| FVector2D::DistSquared(FVector2D(exitPoint), FVector2D(VertX[exitEdgeEnd], VertY[exitEdgeEnd])) <= vertexClearanceSq)
+		{
+			return false;
+		}
+
+		const int32 nextPolyIndex = FindNeighborAcrossEdgePoint(polyIndex, exitPoint);
+		if(nextPolyIndex == INDEX_NONE)
+		{
+			// Nothing on the other side of the edge, it is a navmesh boundary. Its normal is flipped against the segment, back into the poly.
+			bOutHit = true;
+			outHitLocation = exitPoint;
+			outHitNormal = FVector(VertY[exitEdgeStart] - VertY[exitEdgeEnd], VertX[exitEdgeEnd] - VertX[exitEdgeStart], 0.0).GetSafeNormal();
+			if(outHitNormal.X * dirX + outHitNormal.Y * dirY > 0.0)
+			{
+				outHitNormal = -outHitNormal;
+			}
+			return true;
+		}
+
+		polyIndex = nextPolyIndex;
+		enterT = exitT;
+	}
+
+	return false;
+}
+
+int32 FNavCorridorPolyCache::FindNeighborAcrossEdgePoint(int32 polyIndex, const FVector& edgePoint) const
+{
+	// Portals between tiles may only cover part of an edge, so the neighbor is matched on the crossing point instead of shared vertices
+	constexpr FVector::FReal edgeToleranceSq = 1.0;
+	const int32 neighborEnd = PolyNeighborStart[polyIndex] + PolyNeighborCount[polyIndex];
+	for(int32 i = PolyNeighborStart[polyIndex]; i < neighborEnd; i++)
+	{
+		const int32 neighborIndex = NeighborPolyIndices[i];
+		const int32 vertStart = PolyVertStart[neighborIndex];
+		const int32 vertCount = PolyVertCount[neighborIndex];
+		for(int32 v = 0, w = vertCount - 1; v < vertCount; w = v++)
+		{
+			const FVector2D edgeStart(VertX[vertStart + w], VertY[vertStart + w]);
+			const FVector2D edgeEnd(VertX[vertStart + v], VertY[vertStart + v]);
+			const FVector2D closestPoint = FMath::ClosestPointOnSegment2D(FVector2D(edgePoint), edgeStart, edgeEnd);
+			if(FVector2D::DistSquared(closestPoint, FVector2D(edgePoint)) <= edgeToleranceSq)
+			{
+				return neighborIndex;
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 FNavCorridorPolyCache::AddPoly(const ARecastNavMesh& navMesh, NavNodeRef polyRef, TArray<FVector>& vertsScratch)
+{
+	if(const int32* existingIndex = PolyIndexByRef.Find(polyRef))
+	{
+		return *existingIndex;
+	}
+
+	vertsScratch.Reset();
+	if(!navMesh.GetPolyVerts(polyRef, vertsScratch) || vertsScratch.Num() < 3)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 polyIndex = PolyRefs.Emplace(polyRef);
+	PolyIndexByRef.Add(polyRef, polyIndex);
+	PolyVertStart.Emplace(VertX.Num());
+	PolyVertCount.Emplace(vertsScratch.Num());
+	for(const FVector& vert : vertsScratch)
+	{
+		VertX.Emplace(vert.X);
+		VertY.Emplace(vert.Y);
+		VertZ.Emplace(vert.Z);
+	}
+	return polyIndex;
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/Navigation/NavigationTypes.h"
+
+class ARecastNavMesh;
+
+// Local copy of the polygons around a path corridor (the corridor polys and their direct neighbors), fetched from the navmesh once per path.
+// Vertices and neighbor links are kept in flat arrays so the safe bias clamps and the corridor raycasts of the smoothing don't have to go through the ARecastNavMesh API every time.
+struct FNavCorridorPolyCache
+{
+	// corridor is the PathCorridor of the path, or a copy of it
+	void Build(const ARecastNavMesh& navMesh, TConstArrayView<NavNodeRef> corridor);
+	void Reset();
+
+	bool IsEmpty() const { return PolyRefs.IsEmpty(); }
+	int32 NumPolys() const { return PolyRefs.Num(); }
+	int32 FindPolyIndex(NavNodeRef polyRef) const;
+
+	// Index of the poly in the path corridor, replacing the linear FNavMeshPath::GetNodeRefIndex search
+	int32 FindCorridorIndex(NavNodeRef polyRef) const;
+
+	// Closest point on a single cached poly, matching what dtNavMeshQuery::closestPointOnPoly returns up to the detail mesh height
+	void GetClosestPointOnPoly(int32 polyIndex, const FVector& testPt, FVector& pointOnPoly) const;
+
+	// 2D containment test against a cached (convex) poly
+	bool IsPointInPoly2D(int32 polyIndex, const FVector& testPt) const;
+
+	// Raycast through the cached polys, walking from poly to poly across the portals the segment crosses, like dtNavMeshQuery::raycast walks the poly links.
+	// Returns false when the cached data can't decide it: the start is not in a single cached poly, the segment leaves a poly without cached neighbors,
+	// passes exactly through a vertex, or crosses too many polys. Area costs of query filters are not known here, every cached poly is walkable.
+	// On a hit, outHitNormal is the 2D normal of the boundary edge pointing back into the navmesh.
+	bool RaycastLocal(NavNodeRef startPoly, const FVector& segmentStart, const FVector& segmentEnd, bool& bOutHit, FVector& outHitLocation, FVector& outHitNormal) const;
+
+	FVector GetVertex(int32 vertIndex) const { return FVector(VertX[vertIndex], VertY[vertIndex], VertZ[vertIndex]); }
+
+	// Average of the poly vertices
+	FVector GetPolyCenter(int32 polyIndex) const;
+
+	// Per poly data
+	TArray<NavNodeRef> PolyRefs;
+	TArray<int32> PolyVertStart;
+	TArray<int32> PolyVertCount;
+	TArray<int32> PolyNeighborStart;
+	TArray<int32> PolyNeighborCount;
+
+	// Cache indices of neighbors. Only corridor polys have their neighbors linked, the neighbors themselves are leaves.
+	TArray<int32> NeighborPolyIndices;
+
+	// Vertex positions
+	TArray<FVector::FReal> VertX;
+	TArray<FVector::FReal> VertY;
+	TArray<FVector::FReal> VertZ;
+
+private:
+
+	int32 AddPoly(const ARecastNavMesh& navMesh, NavNodeRef polyRef, TArray<FVector>& vertsScratch);
+
+	// Cached neighbor of the poly whose boundary contains the point (within tolerance), INDEX_NONE if there is none
+	int32 FindNeighborAcrossEdgePoint(int32 polyIndex, const FVector& edgePoint) const;
+
+	TMap<NavNodeRef, int32> PolyIndexByRef;
+	TMap<NavNodeRef, int32> CorridorIndexByRef;
+};
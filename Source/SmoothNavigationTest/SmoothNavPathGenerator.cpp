@@ -0,0 +1,613 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavPathGenerator.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "AITypes.h"
+#include "DrawDebugHelpers.h"
+#include "DebugStringsComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Smooth Path"), STAT_SmoothNav_Smooth, STATGROUP_SmoothNav);
+DECLARE_CYCLE_STAT(TEXT("Prepare Queries"), STAT_SmoothNav_PrepareQueries, STATGROUP_SmoothNav);
+DECLARE_CYCLE_STAT(TEXT("Skip Nav Points"), STAT_SmoothNav_SkipNavPoints, STATGROUP_SmoothNav);
+DECLARE_CYCLE_STAT(TEXT("Classify Corners"), STAT_SmoothNav_ClassifyCorners, STATGROUP_SmoothNav);
+DECLARE_CYCLE_STAT(TEXT("Next Point Offsets"), STAT_SmoothNav_NextPointOffsets, STATGROUP_SmoothNav);
+DECLARE_CYCLE_STAT(TEXT("Generate Curves"), STAT_SmoothNav_GenerateCurves, STATGROUP_SmoothNav);
+
+namespace
+{
+	float CyclesToMilliseconds(uint64 startCycles)
+	{
+		return static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+	}
+
+	// Boundary hit moved off the edge it hit, perpendicular to the edge and towards the side the segment came from. False without a usable edge normal.
+	bool GetPushedHitLocation(const FVector& segmentStart, const FVector& hitLocation, const FVector& edgeNormal, float clearance, FVector& outPushedLocation)
+	{
+		FVector pushDir(edgeNormal.X, edgeNormal.Y, 0.0);
+		if(!pushDir.Normalize())
+		{
+			return false;
+		}
+		if(FVector::DotProduct(pushDir, segmentStart - hitLocation) < 0.0)
+		{
+			pushDir = -pushDir;
+		}
+		outPushedLocation = hitLocation + pushDir * clearance;
+		return true;
+	}
+
+	// Boundary hit pulled back along the segment, never behind the start
+	FVector GetPulledBackHitLocation(const FVector& segmentStart, const FVector& hitLocation, float clearance)
+	{
+		const FVector toHit = hitLocation - segmentStart;
+		return segmentStart + toHit.GetSafeNormal() * FMath::Max(0.0, toHit.Size() - clearance);
+	}
+}
+
+void FSmoothNavPathDebugDraw::DrawPoint(const FVector& location, float size, const FColor& color) const
+{
+#if ENABLE_DRAW_DEBUG
+	if(World)
+	{
+		DrawDebugPoint(World, location, size, color, true, -1.f, 0);
+	}
+#endif
+}
+
+void FSmoothNavPathDebugDraw::DrawLine(const FVector& start, const FVector& end, const FColor& color, float thickness) const
+{
+#if ENABLE_DRAW_DEBUG
+	if(World)
+	{
+		DrawDebugLine(World, start, end, color, true, -1.f, 0, thickness);
+	}
+#endif
+}
+
+void FSmoothNavPathDebugDraw::DrawBox(const FVector& center, const FVector& extent, const FColor& color) const
+{
+#if ENABLE_DRAW_DEBUG
+	if(World)
+	{
+		DrawDebugBox(World, center, extent, color, true, -1, 0, 4.f);
+	}
+#endif
+}
+
+void FSmoothNavPathDebugDraw::DrawString(const FString& text, const FColor& color, const FVector& location) const
+{
+#if ENABLE_DRAW_DEBUG
+	if(DebugStrings)
+	{
+		DebugStrings->DrawDebugStringAtLocation(text, color, 1.5f, location);
+	}
+#endif
+}
+
+FSmoothNavPathLiveQueries::FSmoothNavPathLiveQueries(const ARecastNavMesh& inNavMesh, TConstArrayView<NavNodeRef> inPathCorridor, const FSmoothNavPathDebugDraw* inDebugDraw, bool bInExtraDebugInfo, float inExtraClearance)
+	: NavMesh(inNavMesh)
+	, PathCorridor(inPathCorridor)
+	, QueryFilter(inNavMesh.GetDefaultQueryFilter())
+	, DebugDraw(inDebugDraw)
+	, bExtraDebugInfo(bInExtraDebugInfo)
+	, ExtraClearance(inExtraClearance)
+{
+}
+
+void FSmoothNavPathLiveQueries::PrepareQueries()
+{
+	// Fetch the corridor polygons once, safe bias clamps and corridor raycasts during smoothing then run on the local copy
+	if(!PathCorridor.IsEmpty())
+	{
+		CorridorPolyCache.Build(NavMesh, PathCorridor);
+	}
+}
+
+bool FSmoothNavPathLiveQueries::IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation)
+{
+	++NumRaycasts;
+	FRaycastResult raycastResult;
+	const bool bFullyOnNavmesh = !ARecastNavMesh::NavMeshRaycast(&NavMesh, INVALID_NAVNODEREF, segmentStart, segmentEnd, hitLocation, QueryFilter, nullptr, raycastResult);
+	if(!bFullyOnNavmesh && ExtraClearance > 0.f)
+	{
+		// Keep the remaining agent radius clear of the edge that was hit. In spots narrower than that the pushed point can end up off the navmesh or behind another edge,
+		// the hit is then only pulled back along the segment.
+		FVector pushedLocation;
+		FVector pushedHitLocation;
+		if(GetPushedHitLocation(segmentStart, hitLocation, raycastResult.HitNormal, ExtraClearance, pushedLocation) && !Raycast(segmentStart, pushedLocation, pushedHitLocation))
+		{
+			hitLocation = pushedLocation;
+		}
+		else
+		{
+			hitLocation = GetPulledBackHitLocation(segmentStart, hitLocation, ExtraClearance);
+		}
+	}
+	return bFullyOnNavmesh;
+}
+
+bool FSmoothNavPathLiveQueries::IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd)
+{
+	FVector hitLocation;
+	if(Raycast(segmentStart, segmentEnd, hitLocation))
+	{
+		return false;
+	}
+
+	// The lines the extra clearance to either side have to stay on the navmesh too. They are inset along the segment by the clearance,
+	// so they don't start around the navmesh corners the path points sit on.
+	if(ExtraClearance <= 0.f || FVector::Dist2D(segmentStart, segmentEnd) <= 2.f * ExtraClearance)
+	{
+		return true;
+	}
+
+	const FVector segmentDir = (segmentEnd - segmentStart).GetSafeNormal2D();
+	const FVector inset = segmentDir * ExtraClearance;
+	const FVector side = FVector(-segmentDir.Y, segmentDir.X, 0.0) * ExtraClearance;
+	return !Raycast(segmentStart + inset + side, segmentEnd - inset + side, hitLocation)
+		&& !Raycast(segmentStart + inset - side, segmentEnd - inset - side, hitLocation);
+}
+
+bool FSmoothNavPathLiveQueries::ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation)
+{
+	bool bHit = false;
+	FVector hitNormal;
+	if(!CorridorPolyCache.RaycastLocal(startNodeRef, segmentStart, segmentEnd, bHit, outHitLocation, hitNormal))
+	{
+		return false;
+	}
+
+	bOutFullyOnNavmesh = !bHit;
+	if(bHit && ExtraClearance > 0.f)
+	{
+		// Same push off the hit edge as IsSegmentFullyOnNavmesh, checked against the local copy. When it can't decide the pushed point, the hit is pulled back.
+		FVector pushedLocation;
+		bool bPushedHit = true;
+		FVector pushedHitLocation;
+		FVector pushedHitNormal;
+		if(GetPushedHitLocation(segmentStart, outHitLocation, hitNormal, ExtraClearance, pushedLocation)
+			&& CorridorPolyCache.RaycastLocal(startNodeRef, segmentStart, pushedLocation, bPushedHit, pushedHitLocation, pushedHitNormal)
+			&& !bPushedHit)
+		{
+			outHitLocation = pushedLocation;
+		}
+		else
+		{
+			outHitLocation = GetPulledBackHitLocation(segmentStart, outHitLocation, ExtraClearance);
+		}
+	}
+	return true;
+}
+
+void FSmoothNavPathLiveQueries::GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef)
+{
+	// Corridor indices come from the map built with the poly cache instead of two linear GetNodeRefIndex searches
+	const int32 startIndex = CorridorPolyCache.FindCorridorIndex(currentNodeRef);
+	const int32 endIndex = CorridorPolyCache.FindCorridorIndex(nextNodeRef);
+	if(startIndex == INDEX_NONE || endIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Clamp the bias to the closest point on the corridor polys of this segment, against the edges of the local copy
+	FVector safeBias = bias;
+	FVector::FReal smallestDistSq = UE_BIG_NUMBER;
+	int32 safeBiasPolyIndex = INDEX_NONE;
+	for(int32 nodeIndex = startIndex; nodeIndex <= endIndex; nodeIndex++)
+	{
+		const NavNodeRef nodeRef = PathCorridor[nodeIndex];
+		const int32 cachePolyIndex = CorridorPolyCache.FindPolyIndex(nodeRef);
+		if(cachePolyIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		FVector pointOnPoly;
+		CorridorPolyCache.GetClosestPointOnPoly(cachePolyIndex, bias, pointOnPoly);
+		const FVector::FReal distSq = FVector::DistSquared(bias, pointOnPoly);
+		if(distSq < smallestDistSq)
+		{
+			smallestDistSq = distSq;
+			safeBias = pointOnPoly;
+			safeBiasPolyIndex = cachePolyIndex;
+		}
+	}
+
+	// The clamped point is on the poly boundary, move it inwards for agents wider than the navmesh erosion
+	if(ExtraClearance > 0.f && safeBiasPolyIndex != INDEX_NONE)
+	{
+		safeBias += (CorridorPolyCache.GetPolyCenter(safeBiasPolyIndex) - safeBias).GetClampedToMaxSize(ExtraClearance);
+	}
+	bias = safeBias;
+
+	// Polys of the tile the clamp started in, fetched for the debug view only
+	uint32 polyID;
+	uint32 tileID;
+	if(bExtraDebugInfo && DebugDraw && NavMesh.GetPolyTileIndex(currentNodeRef, polyID, tileID))
+	{
+		TArray<FNavPoly> tilePolys;
+		NavMesh.GetPolysInTile(tileID, tilePolys);
+		for(const FNavPoly& tilePoly : tilePolys)
+		{
+			DebugDraw->DrawBox(tilePoly.Center, FVector(30,30,30), FColor::Orange);
+		}
+	}
+}
+
+bool FSmoothNavPathLiveQueries::Raycast(const FVector& rayStart, const FVector& rayEnd, FVector& hitLocation)
+{
+	++NumRaycasts;
+	return NavMesh.Raycast(rayStart, rayEnd, hitLocation, QueryFilter);
+}
+
+FSmoothNavPathGenerator::FSmoothNavPathGenerator(ISmoothNavPathQueries& inQueries, const FSmoothNavPathConfig& inConfig, const FSmoothNavPathDecisions& inDecisions, const FSmoothNavPathDebugDraw* inDebugDraw)
+	: Queries(inQueries)
+	, Config(inConfig)
+	, Decisions(inDecisions)
+	, DebugDraw(inDebugDraw)
+{
+}
+
+void FSmoothNavPathGenerator::Smooth(const TArray<FNavPathPoint>& rawPathPoints, ESmoothPathStorage storage, FCompactSmoothPath& outPath, TArray<FVector>* outSamples, FSmoothNavPathStats* outStats)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SmoothNav_Smooth);
+	const uint64 smoothStartCycles = FPlatformTime::Cycles64();
+	Stats.Reset();
+	Stats.NumRawPoints = rawPathPoints.Num();
+
+	if(rawPathPoints.IsEmpty())
+	{
+		outPath.Reset();
+		if(outSamples)
+		{
+			outSamples->Reset();
+		}
+		if(outStats)
+		{
+			*outStats = Stats;
+		}
+		return;
+	}
+
+	// Fetching navmesh data for the queries is part of the cost of the path
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SmoothNav_PrepareQueries);
+		const uint64 prepareStartCycles = FPlatformTime::Cycles64();
+		Queries.PrepareQueries();
+		Stats.PrepareTimeMs = CyclesToMilliseconds(prepareStartCycles);
+	}
+
+	// Collapse runs of near collinear points first, so the curve stage only sees the corners that matter
+	TArray<FNavPathPoint> navPathPoints;
+	{
+		const uint64 skipStartCycles = FPlatformTime::Cycles64();
+		if(Config.bNavPointSkipping)
+		{
+			SkipNavPoints(rawPathPoints, navPathPoints);
+		}
+		else
+		{
+			navPathPoints = rawPathPoints;
+		}
+		Stats.NumSkippedPoints = rawPathPoints.Num() - navPathPoints.Num();
+		Stats.SkipTimeMs = CyclesToMilliseconds(skipStartCycles);
+	}
+
+	// Smoothing of the points with a custom algorithm including cubic Bezier interpolation
+	TArray<FVector> bezierSmoothedLocations;
+
+	// Classify all corners up front, the loop below only reads the results
+	FSmoothNavPathCorners corners;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SmoothNav_ClassifyCorners);
+		const uint64 classifyStartCycles = FPlatformTime::Cycles64();
+		corners.Classify(navPathPoints, Decisions);
+		Stats.ClassifyTimeMs = CyclesToMilliseconds(classifyStartCycles);
+	}
+
+	TArray<FVector> nextPointLocations;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SmoothNav_NextPointOffsets);
+		const uint64 offsetStartCycles = FPlatformTime::Cycles64();
+		ComputeNextPointOffsets(navPathPoints, corners, nextPointLocations);
+		Stats.OffsetTimeMs = CyclesToMilliseconds(offsetStartCycles);
+	}
+
+	// Curve control points of every generated segment, which is all the compact path needs to keep around
+	TArray<FVector> curveControlPoints;
+	TArray<bool> curveCubicFlags;
+	curveControlPoints.Reserve(navPathPoints.Num() * FCompactSmoothPath::ControlPointsPerSegment);
+	curveCubicFlags.Reserve(navPathPoints.Num());
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SmoothNav_GenerateCurves);
+		const uint64 curveStartCycles = FPlatformTime::Cycles64();
+		for (int32 i = 0; i < navPathPoints.Num(); i++)
+		{
+			// We are generating the point from current to next, so the last point is already generated
+			if (i + 1 == navPathPoints.Num()) {
+				break;
+			}
+
+			// Experimental bias. We need to start with some sort of curve before we make any adjustments.
+			FNavPathPoint currentP = navPathPoints[i];
+			if(!bezierSmoothedLocations.IsEmpty())
+			{
+				currentP.Location = bezierSmoothedLocations[bezierSmoothedLocations.Num() - 1];
+			}
+			FNavPathPoint nextP = navPathPoints[i + 1];
+
+			//Sample current segment direction
+			const FVector currentSegmentDir = corners.SegmentDirs[i];
+
+			// First experimental bias
+			FVector experimentalBias = nextP.Location - currentP.Location;
+			CalculateFirstBiasPoint(experimentalBias, currentP, nextP, bezierSmoothedLocations);
+
+			// Second experimental bias. I am sampling the direction vector of the next segment and invert it in order to choose a decent location for the second bias.
+			// This algorithm ensures that the angles will not be too sharp since it will curve out slightly before curving into the turning point.
+			FVector experimentalBias2 = FAISystem::InvalidLocation;
+			if(i + 2 < navPathPoints.Num())
+			{
+				const FVector& nextSegmentDir = corners.SegmentDirs[i + 1];
+
+				// Debug angles. The turn at the next point is only needed in degrees for display, runs of near collinear points were already collapsed by the skipping pre-pass.
+				if(Config.bEnableExtraDebugInfo && DebugDraw)
+				{
+					const float angle = GetAngleBetweenUnitVectors(currentSegmentDir, nextSegmentDir, EAngleUnits::Degrees);
+					DebugDraw->DrawString(FString::SanitizeFloat(angle), FColor::White, nextP.Location + FVector(0,0, 50));
+				}
+
+				// Determine the second bias position offset based on the angle. Sharper angles usually need a larger offset
+				const float distanceOffset = corners.CornerBias2Offsets[i + 1];
+				experimentalBias2 = nextSegmentDir;
+				experimentalBias2 *= -1;
+				experimentalBias2 *= distanceOffset;
+				experimentalBias2 += nextP.Location;
+			}
+
+			// Adjust the second bias in case it's outside of navmesh
+			FVector testLocBias2;
+			if(FAISystem::IsValidLocation(experimentalBias2) && !IsSegmentFullyOnNavmesh(nextP.Location, experimentalBias2, testLocBias2))
+			{
+				if(DebugDraw)
+				{
+					DebugDraw->DrawString(TEXT("SEGMENT OUT OF BOUNDS!"), FColor::Emerald, experimentalBias2);
+				}
+				experimentalBias2 = testLocBias2;
+				++Stats.NumCorrections;
+			}
+
+			// Next point with its little offset, already clamped to the navmesh
+			nextP.Location = nextPointLocations[i];
+
+			// More debugging
+			if(Config.bEnableExtraDebugInfo && DebugDraw)
+			{
+				// Next location
+				DebugDraw->DrawPoint(nextP.Location, 22.f, FColor::Green);
+
+				// Bias 1
+				DebugDraw->DrawLine(currentP.Location, experimentalBias, FColor::Red, 4.f);
+				DebugDraw->DrawPoint(experimentalBias, 22.f, FColor::Red);
+
+				// Bias 2
+				if(FAISystem::IsValidLocation(experimentalBias2))
+				{
+					DebugDraw->DrawLine(nextP.Location, experimentalBias2, FColor::Yellow, 4.f);
+					DebugDraw->DrawPoint(experimentalBias2, 22.f, FColor::Yellow);
+				}
+			}
+
+			// Using bezier and cubic bezier curve equations (depending on the access to the data that we have), generate intermediate interpolated location points
+			const bool bCubicSegment = FAISystem::IsValidLocation(experimentalBias2);
+			for (float t = 0.0; t <= 1.0; t += FCompactSmoothPath::SampleStep) {
+				FVector pointOnCurve = bCubicSegment ?  GetCubicBezierPoint(t, currentP.Location, experimentalBias, experimentalBias2, nextP.Location) : GetBezierPoint(t, currentP.Location, experimentalBias, nextP.Location);
+				bezierSmoothedLocations.Emplace(pointOnCurve);
+			}
+
+			curveControlPoints.Append({ currentP.Location, experimentalBias, bCubicSegment ? experimentalBias2 : experimentalBias, nextP.Location });
+			curveCubicFlags.Emplace(bCubicSegment);
+		}
+
+		// Add the very last location to the final array
+		bezierSmoothedLocations.Emplace(navPathPoints.Last().Location);
+		Stats.CurveTimeMs = CyclesToMilliseconds(curveStartCycles);
+	}
+
+	// Only the control points are kept, the samples above are scratch data for the smoothing itself
+	const uint64 encodeStartCycles = FPlatformTime::Cycles64();
+	outPath.Encode(curveControlPoints, curveCubicFlags, navPathPoints.Last().Location, storage);
+	Stats.EncodeTimeMs = CyclesToMilliseconds(encodeStartCycles);
+
+	Stats.ComputeShapeMetrics(rawPathPoints, bezierSmoothedLocations);
+	Stats.TotalTimeMs = CyclesToMilliseconds(smoothStartCycles);
+	if(outStats)
+	{
+		*outStats = Stats;
+	}
+
+	if(outSamples)
+	{
+		*outSamples = MoveTemp(bezierSmoothedLocations);
+	}
+}
+
+void FSmoothNavPathGenerator::ComputeNextPointOffsets(const TArray<FNavPathPoint>& navPathPoints, const FSmoothNavPathCorners& corners, TArray<FVector>& outNextPointLocations)
+{
+	const int32 numSegments = corners.SegmentDirs.Num();
+
+	// Apply a little offset to next point. It behaves well with bezier curves where there can be some inconsistencies at key points depending on the bias of the next bezier curve segment.
+	// Tiny additional offset because if nav point is perfectly at the angle of navbounds, the nav raycast can fail due to precision
+	constexpr float miniOffsetNextPoint = 10.f;
+	const float nextPointOffset = Config.NextPointOffset + miniOffsetNextPoint;
+	TArray<FVector> clampStarts;
+	clampStarts.SetNumUninitialized(numSegments);
+	outNextPointLocations.SetNumUninitialized(numSegments);
+	for(int32 i = 0; i < numSegments; i++)
+	{
+		const FVector& nextLocation = navPathPoints[i + 1].Location;
+		clampStarts[i] = nextLocation + corners.SegmentDirs[i] * 5.f;
+		outNextPointLocations[i] = nextLocation + corners.SegmentDirs[i] * nextPointOffset;
+	}
+
+	// Adjust the next point offsets that leave the navmesh. The corridor walk decides almost all of them, a raycast is only needed when it can't.
+	for(int32 i = 0; i < numSegments; i++)
+	{
+		bool bFullyOnNavmesh = true;
+		FVector hitLocation;
+		if(Queries.ClampSegmentToCorridor(clampStarts[i], outNextPointLocations[i], navPathPoints[i + 1].NodeRef, bFullyOnNavmesh, hitLocation))
+		{
+			++Stats.NumCorridorClamps;
+		}
+		else
+		{
+			bFullyOnNavmesh = IsSegmentFullyOnNavmesh(clampStarts[i], outNextPointLocations[i], hitLocation);
+		}
+
+		if(!bFullyOnNavmesh)
+		{
+			outNextPointLocations[i] = hitLocation;
+			++Stats.NumCorrections;
+		}
+	}
+}
+
+void FSmoothNavPathGenerator::SkipNavPoints(const TArray<FNavPathPoint>& pathPoints, TArray<FNavPathPoint>& outPathPoints)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SmoothNav_SkipNavPoints);
+	outPathPoints.Reset(pathPoints.Num());
+	if(pathPoints.Num() < 3)
+	{
+		outPathPoints = pathPoints;
+		return;
+	}
+
+	// Tiny offset due to potential precision inaccuracies from nav raycast. The skipped points are replaced by a straight line, so it has to keep the agent clearance.
+	constexpr float tinyOffset = 10.f;
+	auto isVisibleFromAnchor = [this, tinyOffset](const FVector& anchorLocation, const FVector& targetLocation)
+	{
+		const FVector pullBackDir = (anchorLocation - targetLocation).GetSafeNormal();
+		return IsSegmentClearOfEdges(anchorLocation, targetLocation + pullBackDir * tinyOffset);
+	};
+
+	const int32 lastIndex = pathPoints.Num() - 1;
+
+	// Directions of the raw segments are shared by every anchor
+	TArray<FVector> segmentDirs;
+	segmentDirs.SetNumUninitialized(lastIndex);
+	for(int32 i = 0; i < lastIndex; i++)
+	{
+		segmentDirs[i] = (pathPoints[i + 1].Location - pathPoints[i].Location).GetSafeNormal();
+	}
+
+	int32 anchorIndex = 0;
+	outPathPoints.Emplace(pathPoints[anchorIndex]);
+	while(anchorIndex < lastIndex)
+	{
+		const FVector& anchorLocation = pathPoints[anchorIndex].Location;
+
+		// Extend the run of skip candidates as long as the turn from the anchor direction onto the following segment stays under the threshold. Only dot products, no raycasts.
+		int32 runEndIndex = anchorIndex + 1;
+		while(runEndIndex < lastIndex)
+		{
+			const FVector anchorDir = (pathPoints[runEndIndex].Location - anchorLocation).GetSafeNormal();
+			const float dot = FVector::DotProduct(anchorDir, segmentDirs[runEndIndex]);
+			const bool bSkip = Decisions.ShouldSkip(dot);
+#if DO_ENSURE
+			// The dot threshold must make the same call the angle comparison did. Only exact ties at the threshold may round differently.
+			if(Config.bEnableExtraDebugInfo)
+			{
+				const float angle = GetAngleBetweenUnitVectors(anchorDir, segmentDirs[runEndIndex], EAngleUnits::Degrees);
+				ensureMsgf(bSkip == (angle <= Config.MinAngleSkipThreshold) || FMath::IsNearlyEqual(angle, Config.MinAngleSkipThreshold, 1.e-3f),
+					TEXT("Dot product skip decision differs from the angle based one (angle %f, threshold %f)"), angle, Config.MinAngleSkipThreshold);
+			}
+#endif
+			if(!bSkip)
+			{
+				break;
+			}
+			++runEndIndex;
+		}
+
+		// Binary search the farthest point of the run that is directly reachable from the anchor. The direct neighbor is always reachable through the original path.
+		// Within a near collinear run, visibility is practically monotonic, so O(log n) raycasts replace one raycast (and bias recalculation) per skipped point.
+		int32 lowIndex = anchorIndex + 1;
+		int32 highIndex = runEndIndex;
+		while(lowIndex < highIndex)
+		{
+			const int32 midIndex = (lowIndex + highIndex + 1) / 2;
+			if(isVisibleFromAnchor(anchorLocation, pathPoints[midIndex].Location))
+			{
+				lowIndex = midIndex;
+			}
+			else
+			{
+				highIndex = midIndex - 1;
+			}
+		}
+
+		anchorIndex = lowIndex;
+		outPathPoints.Emplace(pathPoints[anchorIndex]);
+	}
+}
+
+bool FSmoothNavPathGenerator::IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation)
+{
+	// Counted by the queries, one segment can take more than one raycast
+	const int32 numRaycastsBefore = Queries.GetNumRaycasts();
+	const bool bFullyOnNavmesh = Queries.IsSegmentFullyOnNavmesh(segmentStart, segmentEnd, hitLocation);
+	Stats.NumRaycasts += Queries.GetNumRaycasts() - numRaycastsBefore;
+	return bFullyOnNavmesh;
+}
+
+bool FSmoothNavPathGenerator::IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd)
+{
+	FVector dummyHitLoc;
+	return IsSegmentFullyOnNavmesh(segmentStart, segmentEnd, dummyHitLoc);
+}
+
+bool FSmoothNavPathGenerator::IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd)
+{
+	const int32 numRaycastsBefore = Queries.GetNumRaycasts();
+	const bool bClearOfEdges = Queries.IsSegmentClearOfEdges(segmentStart, segmentEnd);
+	Stats.NumRaycasts += Queries.GetNumRaycasts() - numRaycastsBefore;
+	return bClearOfEdges;
+}
+
+void FSmoothNavPathGenerator::CalculateFirstBiasPoint(FVector& bias, const FNavPathPoint& currentPoint, const FNavPathPoint& nextPoint, const TArray<FVector>& smoothPathPoints)
+{
+	bias = nextPoint.Location - currentPoint.Location;
+
+	// Sample experimental bias from actual plotted interpolated points instead if we already have some.
+	if (smoothPathPoints.Num() > 1) {
+		bias = smoothPathPoints[smoothPathPoints.Num() - 1] - smoothPathPoints[smoothPathPoints.Num() - 2];
+	}
+
+	// We plot this bias point at (previous points direction * distance offset + current point location)
+	const float currentSegmentDistanceOffset = FVector::Dist(currentPoint.Location, nextPoint.Location) * Config.Bias1_DistanceScalar;
+	bias.Normalize();
+	bias *= currentSegmentDistanceOffset;
+	bias += currentPoint.Location;
+
+	// Adjust the first bias in case it's outside of navmesh
+	FVector testLocBias1;
+	if(!IsSegmentFullyOnNavmesh(currentPoint.Location, bias, testLocBias1))
+	{
+		if(DebugDraw)
+		{
+			DebugDraw->DrawString(TEXT("SEGMENT OUT OF BOUNDS!"), FColor::Emerald, bias);
+		}
+		bias = testLocBias1;
+		++Stats.NumCorrections;
+
+		// Trace from nextP to bias to check for more potential navmesh inconsistencies. If there's no valid segment from nextP to bias then we need to clamp it to whatever it can be there.
+		FVector testLocBias1Extra;
+		if(!IsSegmentFullyOnNavmesh(nextPoint.Location, bias, testLocBias1Extra))
+		{
+			// Tile stuff
+			Queries.GetSafeBiasLocation(bias, currentPoint.NodeRef, nextPoint.NodeRef);
+			++Stats.NumSafeBiasClamps;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "AI/Navigation/NavQueryFilter.h"
+#include "CompactSmoothPath.h"
+#include "NavPolyCache.h"
+#include "SmoothNavPathTypes.h"
+#include "SmoothNavPathStats.h"
+
+class ARecastNavMesh;
+class UDebugStringsComponent;
+
+// Navmesh queries the smoothing depends on. Kept behind an interface so the same smoothing runs against the live navmesh, records what it asked, or replays a recording without a world.
+class ISmoothNavPathQueries
+{
+public:
+	virtual ~ISmoothNavPathQueries() = default;
+
+	// Called once at the start of every smoothing, before the first query. Setup that fetches navmesh data belongs here, so it is timed as part of the smoothing.
+	virtual void PrepareQueries() {}
+
+	// True when the segment is fully on the navmesh, otherwise hitLocation is where it leaves it
+	virtual bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) = 0;
+
+	// Stricter IsSegmentFullyOnNavmesh for straight shortcuts the agent follows as they are: the segment also has to keep any extra agent clearance from the navmesh edges
+	virtual bool IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd)
+	{
+		FVector hitLocation;
+		return IsSegmentFullyOnNavmesh(segmentStart, segmentEnd, hitLocation);
+	}
+
+	// Clamp an out of bounds bias to the corridor polys between the polys of the two path points
+	virtual void GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef) = 0;
+
+	// Same answer as IsSegmentFullyOnNavmesh for a short segment starting at the poly startNodeRef, but from local corridor data instead of a navmesh raycast.
+	// Returns false when the local data can't decide it, the caller then falls back to IsSegmentFullyOnNavmesh.
+	virtual bool ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation) { return false; }
+
+	// Navmesh raycasts issued by these queries so far. A single query can take several, e.g. for the extra clearance.
+	virtual int32 GetNumRaycasts() const = 0;
+};
+
+// Optional debug output of the smoothing. Nothing is drawn without a world.
+struct FSmoothNavPathDebugDraw
+{
+	UWorld* World = nullptr;
+	UDebugStringsComponent* DebugStrings = nullptr;
+
+	void DrawPoint(const FVector& location, float size, const FColor& color) const;
+	void DrawLine(const FVector& start, const FVector& end, const FColor& color, float thickness) const;
+	void DrawBox(const FVector& center, const FVector& extent, const FColor& color) const;
+	void DrawString(const FString& text, const FColor& color, const FVector& location) const;
+};
+
+// Queries answered by the live navmesh. Safe bias clamps and next point offsets go through the local corridor poly cache instead.
+// inExtraClearance keeps agents larger than the agent of the navmesh that much further away from the navmesh edges: hits are pushed off the edge they hit,
+// and shortcuts need the lines that far to either side on the navmesh too. The curves between the control points are not tested, they are only as clear as the points.
+// inPathCorridor is the PathCorridor of the path being smoothed (empty for paths that are not navmesh paths) and has to outlive the queries.
+class FSmoothNavPathLiveQueries : public ISmoothNavPathQueries
+{
+public:
+	FSmoothNavPathLiveQueries(const ARecastNavMesh& inNavMesh, TConstArrayView<NavNodeRef> inPathCorridor, const FSmoothNavPathDebugDraw* inDebugDraw, bool bInExtraDebugInfo, float inExtraClearance = 0.f);
+
+	// Fetches the corridor polys into the local cache
+	virtual void PrepareQueries() override;
+	virtual bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) override;
+	virtual bool IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd) override;
+	virtual void GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef) override;
+	virtual bool ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation) override;
+	virtual int32 GetNumRaycasts() const override { return NumRaycasts; }
+
+private:
+	bool Raycast(const FVector& rayStart, const FVector& rayEnd, FVector& hitLocation);
+
+	const ARecastNavMesh& NavMesh;
+	TConstArrayView<NavNodeRef> PathCorridor;
+	FSharedConstNavQueryFilter QueryFilter;
+
+	const FSmoothNavPathDebugDraw* DebugDraw = nullptr;
+	bool bExtraDebugInfo = false;
+	float ExtraClearance = 0.f;
+	int32 NumRaycasts = 0;
+
+	FNavCorridorPolyCache CorridorPolyCache;
+};
+
+// The smoothing algorithm itself: nav point skipping followed by bias placement and bezier interpolation of every segment
+class FSmoothNavPathGenerator
+{
+public:
+	FSmoothNavPathGenerator(ISmoothNavPathQueries& inQueries, const FSmoothNavPathConfig& inConfig, const FSmoothNavPathDecisions& inDecisions, const FSmoothNavPathDebugDraw* inDebugDraw = nullptr);
+
+	// Smooth the raw path points into outPath. The interpolated samples and the stats of the path are only returned when asked for.
+	void Smooth(const TArray<FNavPathPoint>& pathPoints, ESmoothPathStorage storage, FCompactSmoothPath& outPath, TArray<FVector>* outSamples = nullptr, FSmoothNavPathStats* outStats = nullptr);
+
+	// Greedy string pulling over the raw path points. Collapses runs of near collinear points into the farthest point still visible from the start of the run.
+	void SkipNavPoints(const TArray<FNavPathPoint>& pathPoints, TArray<FNavPathPoint>& outPathPoints);
+
+private:
+	// Clamp the NextPointOffset nudge of every segment in one pass. Each one only depends on the raw points, not on the curves built so far.
+	void ComputeNextPointOffsets(const TArray<FNavPathPoint>& navPathPoints, const FSmoothNavPathCorners& corners, TArray<FVector>& outNextPointLocations);
+
+	bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation);
+	bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd);
+	bool IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd);
+	void CalculateFirstBiasPoint(FVector& bias, const FNavPathPoint& currentPoint, const FNavPathPoint& nextPoint, const TArray<FVector>& smoothPathPoints);
+
+	ISmoothNavPathQueries& Queries;
+	const FSmoothNavPathConfig& Config;
+	const FSmoothNavPathDecisions& Decisions;
+	const FSmoothNavPathDebugDraw* DebugDraw = nullptr;
+
+	// Stats of the path currently being smoothed
+	FSmoothNavPathStats Stats;
+};
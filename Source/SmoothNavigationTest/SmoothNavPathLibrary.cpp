@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavPathLibrary.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "SmoothNavPathGenerator.h"
+#include "SmoothNavPathSubsystem.h"
+#include "SmoothNavReplay.h"
+
+bool USmoothNavPathLibrary::FindSmoothPathSync(UObject* worldContextObject, const FVector& startLocation, const FVector& goalLocation, const FNavAgentProperties& agentProperties, const FSmoothNavPathConfig& config, TSubclassOf<UNavigationQueryFilter> filterClass, TArray<FVector>& outPathPoints, FSmoothNavPathStats& outStats)
+{
+	outPathPoints.Reset();
+	outStats.Reset();
+
+	UWorld* world = GEngine ? GEngine->GetWorldFromContextObject(worldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(world);
+	const FSmoothNavAgentTypeData* agentTypeData = agentProperties.IsValid() && smoothNavPathSubsystem ? smoothNavPathSubsystem->GetAgentTypeData(agentProperties) : nullptr;
+	const float extraClearance = agentTypeData ? agentTypeData->ExtraClearance : 0.f;
+	const ARecastNavMesh* navMesh = nullptr;
+	if(agentTypeData)
+	{
+		navMesh = Cast<ARecastNavMesh>(agentTypeData->NavigationData.Get());
+	}
+	else if(navSystem)
+	{
+		navMesh = Cast<ARecastNavMesh>(navSystem->GetDefaultNavDataInstance());
+	}
+
+	if(!navSystem || !navMesh)
+	{
+		return false;
+	}
+
+	const FPathFindingQuery query(worldContextObject, *navMesh, startLocation, goalLocation, UNavigationQueryFilter::GetQueryFilter(*navMesh, worldContextObject, filterClass));
+	const FPathFindingResult pathFindingResult = navSystem->FindPathSync(query);
+	if(!pathFindingResult.IsSuccessful())
+	{
+		return false;
+	}
+
+	// Samples are all a caller of this variant gets, so the control points are kept at full precision
+	FCompactSmoothPath smoothedPath;
+	return SmoothNavPath(world, *navMesh, pathFindingResult.Path, config, ESmoothPathStorage::Full, extraClearance, smoothedPath, &outPathPoints, &outStats);
+}
+
+bool USmoothNavPathLibrary::SmoothNavPath(UWorld* world, const ARecastNavMesh& navMesh, FNavPathSharedPtr path, const FSmoothNavPathConfig& config, ESmoothPathStorage storage, float extraClearance, FCompactSmoothPath& outPath, TArray<FVector>* outSamples, FSmoothNavPathStats* outStats)
+{
+	if(!path.IsValid() || path->GetPathPoints().IsEmpty())
+	{
+		outPath.Reset();
+		return false;
+	}
+
+	// Debug toggles of the config are ignored, there is nothing to draw to
+	USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(world);
+	FSmoothNavPathDecisions localDecisions;
+	const FSmoothNavPathDecisions* decisions = smoothNavPathSubsystem ? &smoothNavPathSubsystem->GetSmoothingDecisions(config) : nullptr;
+	if(!decisions)
+	{
+		localDecisions.Build(config);
+		decisions = &localDecisions;
+	}
+
+	const FNavMeshPath* navMeshPath = path->CastPath<const FNavMeshPath>();
+	const TConstArrayView<NavNodeRef> pathCorridor = navMeshPath ? TConstArrayView<NavNodeRef>(navMeshPath->PathCorridor) : TConstArrayView<NavNodeRef>();
+	FSmoothNavPathLiveQueries liveQueries(navMesh, pathCorridor, nullptr, false, extraClearance);
+	FSmoothNavReplayRecorder replayRecorder(liveQueries);
+	FSmoothNavPathGenerator generator(replayRecorder.GetQueries(), config, *decisions);
+
+	FSmoothNavPathStats stats;
+	generator.Smooth(path->GetPathPoints(), storage, outPath, replayRecorder.GetSamples(outSamples), &stats);
+	stats.Report();
+
+	// The filter the path was found with is not known here
+	replayRecorder.Finish(path->GetPathPoints(), pathCorridor, config, storage, TEXT("None"), stats);
+	if(outStats)
+	{
+		*outStats = stats;
+	}
+	return !outPath.IsEmpty();
+}
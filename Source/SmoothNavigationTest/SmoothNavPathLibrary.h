@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "NavigationData.h"
+#include "CompactSmoothPath.h"
+#include "SmoothNavPathTypes.h"
+#include "SmoothNavPathStats.h"
+#include "SmoothNavPathLibrary.generated.h"
+
+class ARecastNavMesh;
+class UNavigationQueryFilter;
+
+// Smoothing entry points for gameplay code (AI controllers, path following) that only need the result.
+// Nothing here draws, touches a debug component or GEngine, so it runs the same on a dedicated server or with -nullrhi.
+UCLASS()
+class SMOOTHNAVIGATIONTEST_API USmoothNavPathLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+
+	// Find a path on the navigation data of the agent type and smooth it. outPathPoints receives the sampled smooth path.
+	UFUNCTION(BlueprintCallable, Category="Smooth Path", meta=(WorldContext="worldContextObject"))
+	static bool FindSmoothPathSync(UObject* worldContextObject, const FVector& startLocation, const FVector& goalLocation, const FNavAgentProperties& agentProperties, const FSmoothNavPathConfig& config, TSubclassOf<UNavigationQueryFilter> filterClass, TArray<FVector>& outPathPoints, FSmoothNavPathStats& outStats);
+
+	// Smooth a path that was already found, e.g. the one a path following component is about to follow.
+	// extraClearance is the agent radius not covered by the erosion of navMesh (see FSmoothNavAgentTypeData).
+	static bool SmoothNavPath(UWorld* world, const ARecastNavMesh& navMesh, FNavPathSharedPtr path, const FSmoothNavPathConfig& config, ESmoothPathStorage storage, float extraClearance, FCompactSmoothPath& outPath, TArray<FVector>* outSamples = nullptr, FSmoothNavPathStats* outStats = nullptr);
+};
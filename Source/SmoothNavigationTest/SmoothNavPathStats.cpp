@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavPathStats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Smoothed Paths"), STAT_SmoothNav_NumPaths, STATGROUP_SmoothNav);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Skipped Points"), STAT_SmoothNav_NumSkippedPoints, STATGROUP_SmoothNav);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Raycasts"), STAT_SmoothNav_NumRaycasts, STATGROUP_SmoothNav);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corridor Clamps"), STAT_SmoothNav_NumCorridorClamps, STATGROUP_SmoothNav);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections"), STAT_SmoothNav_NumCorrections, STATGROUP_SmoothNav);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Safe Bias Clamps"), STAT_SmoothNav_NumSafeBiasClamps, STATGROUP_SmoothNav);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Smoothing Time (ms)"), STAT_SmoothNav_TotalTimeMs, STATGROUP_SmoothNav);
+
+CSV_DEFINE_CATEGORY(SmoothNav, true);
+
+void FSmoothNavPathStats::ComputeShapeMetrics(const TArray<FNavPathPoint>& rawPathPoints, const TArray<FVector>& samples)
+{
+	RawLength = 0.f;
+	for(int32 i = 1; i < rawPathPoints.Num(); i++)
+	{
+		RawLength += FVector::Dist(rawPathPoints[i - 1].Location, rawPathPoints[i].Location);
+	}
+
+	SmoothedLength = 0.f;
+	MaxCurvature = 0.f;
+	for(int32 i = 1; i < samples.Num(); i++)
+	{
+		const FVector& a = samples[i - 1];
+		const FVector& b = samples[i];
+		SmoothedLength += FVector::Dist(a, b);
+		if(i + 1 >= samples.Num())
+		{
+			continue;
+		}
+
+		// Curvature of the circle through three consecutive samples (Menger curvature), no trigonometry needed
+		const FVector& c = samples[i + 1];
+		const FVector::FReal lengthProduct = FVector::Dist(a, b) * FVector::Dist(b, c) * FVector::Dist(a, c);
+		if(lengthProduct > UE_KINDA_SMALL_NUMBER)
+		{
+			const float curvature = 2.0 * FVector::CrossProduct(b - a, c - b).Size() / lengthProduct;
+			MaxCurvature = FMath::Max(MaxCurvature, curvature);
+		}
+	}
+}
+
+void FSmoothNavPathStats::Report() const
+{
+	INC_DWORD_STAT(STAT_SmoothNav_NumPaths);
+	INC_DWORD_STAT_BY(STAT_SmoothNav_NumSkippedPoints, NumSkippedPoints);
+	INC_DWORD_STAT_BY(STAT_SmoothNav_NumRaycasts, NumRaycasts);
+	INC_DWORD_STAT_BY(STAT_SmoothNav_NumCorridorClamps, NumCorridorClamps);
+	INC_DWORD_STAT_BY(STAT_SmoothNav_NumCorrections, NumCorrections);
+	INC_DWORD_STAT_BY(STAT_SmoothNav_NumSafeBiasClamps, NumSafeBiasClamps);
+	INC_FLOAT_STAT_BY(STAT_SmoothNav_TotalTimeMs, TotalTimeMs);
+
+	// Per frame totals, plus the worst path of the frame for the quality and time values
+	CSV_CUSTOM_STAT(SmoothNav, NumPaths, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, NumSkippedPoints, NumSkippedPoints, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, NumRaycasts, NumRaycasts, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, NumCorridorClamps, NumCorridorClamps, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, NumCorrections, NumCorrections, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, TotalTimeMs, TotalTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, PrepareTimeMs, PrepareTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, SkipTimeMs, SkipTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, ClassifyTimeMs, ClassifyTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, OffsetTimeMs, OffsetTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, CurveTimeMs, CurveTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, EncodeTimeMs, EncodeTimeMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SmoothNav, MaxPathTimeMs, TotalTimeMs, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(SmoothNav, MaxCurvature, MaxCurvature, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(SmoothNav, MaxLengthRatio, GetLengthRatio(), ECsvCustomStatOp::Max);
+}
+
+FString FSmoothNavPathStats::ToString() const
+{
+	return FString::Printf(TEXT("Length %.0f / %.0f (x%.3f), max curvature %.4f, points %d (%d skipped), raycasts %d, corridor clamps %d, corrections %d (%d clamped), time %.3f ms (prepare %.3f, skip %.3f, classify %.3f, offsets %.3f, curve %.3f, encode %.3f)"),
+		SmoothedLength, RawLength, GetLengthRatio(), MaxCurvature, NumRawPoints, NumSkippedPoints, NumRaycasts, NumCorridorClamps, NumCorrections, NumSafeBiasClamps,
+		TotalTimeMs, PrepareTimeMs, SkipTimeMs, ClassifyTimeMs, OffsetTimeMs, CurveTimeMs, EncodeTimeMs);
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "SmoothNavPathStats.generated.h"
+
+// "stat SmoothNav" shows the per frame totals of every smoothed path
+DECLARE_STATS_GROUP(TEXT("SmoothNav"), STATGROUP_SmoothNav, STATCAT_Advanced);
+
+// Quality and cost of one smoothed path
+USTRUCT(BlueprintType)
+struct FSmoothNavPathStats
+{
+	GENERATED_BODY()
+
+	// Length of the engine path and of the sampled smooth path
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float RawLength = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float SmoothedLength = 0.f;
+
+	// Highest curvature (1 / turn radius, in 1/cm) between consecutive samples of the smooth path
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float MaxCurvature = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumRawPoints = 0;
+
+	// Raw points collapsed by the nav point skipping pre-pass
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumSkippedPoints = 0;
+
+	// Navmesh raycasts issued by skipping and smoothing
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumRaycasts = 0;
+
+	// Bias and next point offsets that left the navmesh and had to be pulled back onto it
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumCorrections = 0;
+
+	// Next point offsets clamped by walking the cached corridor polys instead of a navmesh raycast
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumCorridorClamps = 0;
+
+	// Corrections that needed the corridor poly clamp on top of the raycast hit
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	int32 NumSafeBiasClamps = 0;
+
+	// Time per stage, in milliseconds. Prepare is the query setup, e.g. fetching the corridor polys from the navmesh.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float PrepareTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float SkipTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float ClassifyTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float OffsetTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float CurveTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float EncodeTimeMs = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Smooth Path|Stats")
+	float TotalTimeMs = 0.f;
+
+	void Reset() { *this = FSmoothNavPathStats(); }
+
+	// How much longer the smooth path is than the raw one
+	float GetLengthRatio() const { return RawLength > UE_KINDA_SMALL_NUMBER ? SmoothedLength / RawLength : 1.f; }
+
+	// Lengths and curvature, measured once the samples exist
+	void ComputeShapeMetrics(const TArray<FNavPathPoint>& rawPathPoints, const TArray<FVector>& samples);
+
+	// Add this path to the "stat SmoothNav" counters and the SmoothNav csv profiler category
+	void Report() const;
+
+	FString ToString() const;
+};
@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavPathSubsystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavigationSystem.h"
+#include "SmoothNavPathGenerator.h"
+#include "SmoothNavReplay.h"
+
+static TAutoConsoleVariable<float> CVarSmoothNavPredictionBudgetMs(
+	TEXT("smoothnav.Prediction.BudgetMs"),
+	0.5f,
+	TEXT("Game thread time (in ms) spent per frame on smoothing queued predictions. At least one prediction is smoothed every frame while any are queued."));
+
+void USmoothNavPathSubsystem::Deinitialize()
+{
+	if(QueuedPredictionsTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(QueuedPredictionsTickerHandle);
+		QueuedPredictionsTickerHandle.Reset();
+	}
+
+	SmoothingDecisions.Empty();
+	AgentTypeData.Empty();
+	InvalidatePredictions();
+
+	Super::Deinitialize();
+}
+
+const FSmoothNavPathDecisions& USmoothNavPathSubsystem::GetSmoothingDecisions(const FSmoothNavPathConfig& config)
+{
+	if(const FSmoothNavPathDecisions* decisions = SmoothingDecisions.Find(config))
+	{
+		return *decisions;
+	}
+
+	FSmoothNavPathDecisions& decisions = SmoothingDecisions.Add(config);
+	decisions.Build(config);
+	return decisions;
+}
+
+const FSmoothNavAgentTypeData* USmoothNavPathSubsystem::GetAgentTypeData(const FNavAgentProperties& agentProperties)
+{
+	// Navigation data can be unregistered at any time, resolve again once it is gone
+	FSmoothNavAgentTypeData& agentTypeData = AgentTypeData.FindOrAdd(agentProperties);
+	if(!agentTypeData.NavigationData.IsValid())
+	{
+		UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+		ANavigationData* navigationData = navSystem ? navSystem->GetNavDataForProps(agentProperties) : nullptr;
+		if(!navigationData)
+		{
+			AgentTypeData.Remove(agentProperties);
+			return nullptr;
+		}
+
+		agentTypeData.NavigationData = navigationData;
+		agentTypeData.ExtraClearance = FMath::Max(0.f, agentProperties.AgentRadius - navigationData->GetConfig().AgentRadius);
+	}
+	return &agentTypeData;
+}
+
+uint32 USmoothNavPathSubsystem::MakePredictionKey(const FVector& startLocation, const FVector& goalLocation, uint32 configHash)
+{
+	// Snapped to the tolerance grid, the exact distances are checked again when consuming
+	const FIntVector startCell(FMath::RoundToInt32(startLocation.X / PredictionLocationTolerance), FMath::RoundToInt32(startLocation.Y / PredictionLocationTolerance), FMath::RoundToInt32(startLocation.Z / PredictionLocationTolerance));
+	const FIntVector goalCell(FMath::RoundToInt32(goalLocation.X / PredictionLocationTolerance), FMath::RoundToInt32(goalLocation.Y / PredictionLocationTolerance), FMath::RoundToInt32(goalLocation.Z / PredictionLocationTolerance));
+	return HashCombine(HashCombine(GetTypeHash(startCell), GetTypeHash(goalCell)), configHash);
+}
+
+bool USmoothNavPathSubsystem::BeginPrediction(uint32 predictionKey)
+{
+	if(PendingPredictions.Contains(predictionKey) || Predictions.Contains(predictionKey))
+	{
+		return false;
+	}
+
+	PendingPredictions.Add(predictionKey);
+	return true;
+}
+
+void USmoothNavPathSubsystem::CancelPrediction(uint32 predictionKey)
+{
+	PendingPredictions.Remove(predictionKey);
+}
+
+void USmoothNavPathSubsystem::FinishPrediction(uint32 predictionKey, uint32 predictionGeneration, FSmoothNavPrediction&& prediction)
+{
+	// A prediction started before the last invalidation was already dropped from the pending set
+	if(predictionGeneration != PredictionGeneration || PendingPredictions.Remove(predictionKey) == 0 || prediction.Path.IsEmpty())
+	{
+		return;
+	}
+
+	Predictions.Add(predictionKey, MoveTemp(prediction));
+}
+
+void USmoothNavPathSubsystem::QueuePrediction(FSmoothNavPredictionRequest&& request)
+{
+	QueuedPredictions.Emplace(MoveTemp(request));
+	if(!QueuedPredictionsTickerHandle.IsValid())
+	{
+		QueuedPredictionsTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &USmoothNavPathSubsystem::TickQueuedPredictions));
+	}
+}
+
+bool USmoothNavPathSubsystem::TickQueuedPredictions(float deltaTime)
+{
+	const double budgetMs = CVarSmoothNavPredictionBudgetMs.GetValueOnGameThread();
+	const uint64 tickStartCycles = FPlatformTime::Cycles64();
+	int32 numSmoothed = 0;
+	while(numSmoothed < QueuedPredictions.Num() && (numSmoothed == 0 || FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - tickStartCycles) < budgetMs))
+	{
+		SmoothQueuedPrediction(QueuedPredictions[numSmoothed]);
+		++numSmoothed;
+	}
+	QueuedPredictions.RemoveAt(0, numSmoothed, false);
+
+	// The ticker is removed once the queue is drained and added again by the next QueuePrediction
+	if(QueuedPredictions.IsEmpty())
+	{
+		QueuedPredictionsTickerHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+void USmoothNavPathSubsystem::SmoothQueuedPrediction(const FSmoothNavPredictionRequest& request)
+{
+	// Cancelled or invalidated while it was queued
+	if(request.PredictionGeneration != PredictionGeneration || !PendingPredictions.Contains(request.PredictionKey))
+	{
+		return;
+	}
+
+	const ARecastNavMesh* navMesh = request.NavMesh.Get();
+	if(!navMesh)
+	{
+		CancelPrediction(request.PredictionKey);
+		return;
+	}
+
+	FSmoothNavPrediction prediction;
+	prediction.ConfigHash = request.ConfigHash;
+	prediction.StartLocation = request.StartLocation;
+	prediction.GoalLocation = request.GoalLocation;
+	prediction.NavPath = request.NavPath;
+
+	FSmoothNavPathLiveQueries liveQueries(*navMesh, request.PathCorridor, nullptr, false, request.ExtraClearance);
+	FSmoothNavReplayRecorder replayRecorder(liveQueries);
+	FSmoothNavPathGenerator generator(replayRecorder.GetQueries(), request.Config, GetSmoothingDecisions(request.Config));
+	generator.Smooth(request.PathPoints, request.Storage, prediction.Path, replayRecorder.GetSamples(nullptr), &prediction.Stats);
+	prediction.Stats.Report();
+	replayRecorder.Finish(request.PathPoints, request.PathCorridor, request.Config, request.Storage, request.FilterClassName, prediction.Stats);
+
+	++NumSmoothedPredictions;
+	SmoothedPredictionTimeMs += prediction.Stats.TotalTimeMs;
+	FinishPrediction(request.PredictionKey, request.PredictionGeneration, MoveTemp(prediction));
+}
+
+bool USmoothNavPathSubsystem::ConsumePrediction(uint32 configHash, const FVector& startLocation, const FVector& goalLocation, FSmoothNavPrediction& outPrediction)
+{
+	// The cache holds at most MaxCachedPredictions, scanning it is cheaper than probing every neighboring grid cell of start and goal
+	const FVector::FReal toleranceSq = FMath::Square(PredictionLocationTolerance);
+	FVector::FReal bestDistSq = UE_BIG_NUMBER;
+	uint32 bestPredictionKey = 0;
+	const FSmoothNavPrediction* bestPrediction = nullptr;
+	for(TLruCache<uint32, FSmoothNavPrediction>::TConstIterator it(Predictions); it; ++it)
+	{
+		const FSmoothNavPrediction& prediction = it.Value();
+		const FVector::FReal startDistSq = FVector::DistSquared(prediction.StartLocation, startLocation);
+		const FVector::FReal goalDistSq = FVector::DistSquared(prediction.GoalLocation, goalLocation);
+		if(prediction.ConfigHash == configHash && startDistSq <= toleranceSq && goalDistSq <= toleranceSq && startDistSq + goalDistSq < bestDistSq)
+		{
+			bestDistSq = startDistSq + goalDistSq;
+			bestPredictionKey = it.Key();
+			bestPrediction = &prediction;
+		}
+	}
+
+	if(!bestPrediction)
+	{
+		return false;
+	}
+
+	// The engine path gets observed by whoever consumes it, so it is never handed out twice
+	outPrediction = *bestPrediction;
+	Predictions.Remove(bestPredictionKey);
+	return true;
+}
+
+void USmoothNavPathSubsystem::InvalidatePredictions()
+{
+	Predictions.Empty(MaxCachedPredictions);
+	PendingPredictions.Empty();
+	QueuedPredictions.Empty();
+	++PredictionGeneration;
+}
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Containers/LruCache.h"
+#include "Containers/Ticker.h"
+#include "NavigationData.h"
+#include "CompactSmoothPath.h"
+#include "SmoothNavPathTypes.h"
+#include "SmoothNavPathStats.h"
+#include "SmoothNavPathSubsystem.generated.h"
+
+class ARecastNavMesh;
+class ANavigationData;
+
+// Navigation data resolved for one agent type, together with what the smoothing needs on top of it
+struct FSmoothNavAgentTypeData
+{
+	TWeakObjectPtr<ANavigationData> NavigationData;
+
+	// Navmeshes are only eroded by the radius of their own agent. Larger agents keep this much extra distance from the edges.
+	float ExtraClearance = 0.f;
+};
+
+// Map key functions for agent properties, on the values the navigation data and clearance of an agent type are resolved from.
+// Equal hashes of different agent types still get their own entries.
+template<typename ValueType>
+struct TSmoothNavAgentPropertiesKeyFuncs : TDefaultMapKeyFuncs<FNavAgentProperties, ValueType, false>
+{
+	static bool Matches(const FNavAgentProperties& a, const FNavAgentProperties& b)
+	{
+		return a.AgentRadius == b.AgentRadius && a.AgentHeight == b.AgentHeight && a.PreferredNavData == b.PreferredNavData;
+	}
+
+	static uint32 GetKeyHash(const FNavAgentProperties& key)
+	{
+		uint32 hash = GetTypeHash(key.AgentRadius);
+		hash = HashCombine(hash, GetTypeHash(key.AgentHeight));
+		return HashCombine(hash, GetTypeHash(key.PreferredNavData));
+	}
+};
+
+// A path smoothed ahead of time for a likely request
+struct FSmoothNavPrediction
+{
+	// Hash of everything besides start and goal that affects the path, see AATestingNavigatingActor::GetPredictionConfigHash
+	uint32 ConfigHash = 0;
+	FVector StartLocation = FVector::ZeroVector;
+	FVector GoalLocation = FVector::ZeroVector;
+	FNavPathSharedPtr NavPath;
+	FCompactSmoothPath Path;
+	FSmoothNavPathStats Stats;
+};
+
+// Everything a queued prediction is smoothed from, copied on the game thread when its path was found.
+// The engine path can be repathed and the requesting actor changed or destroyed before the smoothing runs.
+struct FSmoothNavPredictionRequest
+{
+	uint32 PredictionKey = 0;
+	uint32 PredictionGeneration = 0;
+	TWeakObjectPtr<const ARecastNavMesh> NavMesh;
+	TArray<FNavPathPoint> PathPoints;
+	TArray<NavNodeRef> PathCorridor;
+	FSmoothNavPathConfig Config;
+	ESmoothPathStorage Storage = ESmoothPathStorage::Full;
+	float ExtraClearance = 0.f;
+
+	// Only for replay recordings, see FSmoothNavReplayRequest::FilterClassName
+	FString FilterClassName;
+
+	// Handed to whoever consumes the prediction
+	uint32 ConfigHash = 0;
+	FVector StartLocation = FVector::ZeroVector;
+	FVector GoalLocation = FVector::ZeroVector;
+	FNavPathSharedPtr NavPath;
+};
+
+// World wide data shared by every smoothed path in the world
+UCLASS()
+class SMOOTHNAVIGATIONTEST_API USmoothNavPathSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// Navigation data and clearance for the given agent properties, resolved once per agent type. Null without navigation data, only valid until the next call.
+	const FSmoothNavAgentTypeData* GetAgentTypeData(const FNavAgentProperties& agentProperties);
+
+	// Decision thresholds shared by every path smoothed with the same config. The reference is only valid until the next call.
+	const FSmoothNavPathDecisions& GetSmoothingDecisions(const FSmoothNavPathConfig& config);
+
+	// Predictions are matched on start and goal within this distance, plus a hash of everything else that affects the path
+	static constexpr float PredictionLocationTolerance = 25.f;
+	static constexpr int32 MaxCachedPredictions = 64;
+
+	// Reservation key of a prediction, with start and goal snapped to a grid of PredictionLocationTolerance.
+	// Only keeps the same prediction from being computed twice, lookups match on the actual distances.
+	static uint32 MakePredictionKey(const FVector& startLocation, const FVector& goalLocation, uint32 configHash);
+
+	// Reserve a prediction. False when it is already cached or being computed.
+	bool BeginPrediction(uint32 predictionKey);
+	void CancelPrediction(uint32 predictionKey);
+
+	// Store a finished prediction, unless the navmesh changed since it was started
+	void FinishPrediction(uint32 predictionKey, uint32 predictionGeneration, FSmoothNavPrediction&& prediction);
+
+	// Smooth a reserved prediction later on the game thread. Queued predictions are smoothed in order, within smoothnav.Prediction.BudgetMs per frame.
+	// This is not a background offload: the smoothing queries the live navmesh, which the game thread modifies with no lock that would make worker queries safe.
+	// Predictions still cost frame time. The budget spreads and caps that cost, and it is only paid before the goal switch instead of during it.
+	void QueuePrediction(FSmoothNavPredictionRequest&& request);
+
+	// Take the closest prediction with the same config hash and start and goal within PredictionLocationTolerance out of the cache
+	bool ConsumePrediction(uint32 configHash, const FVector& startLocation, const FVector& goalLocation, FSmoothNavPrediction& outPrediction);
+
+	// Drop every prediction, including the ones still being computed
+	void InvalidatePredictions();
+	uint32 GetPredictionGeneration() const { return PredictionGeneration; }
+
+	// Game thread time spent on queued predictions so far
+	int32 GetNumSmoothedPredictions() const { return NumSmoothedPredictions; }
+	double GetSmoothedPredictionTimeMs() const { return SmoothedPredictionTimeMs; }
+
+private:
+
+	bool TickQueuedPredictions(float deltaTime);
+	void SmoothQueuedPrediction(const FSmoothNavPredictionRequest& request);
+
+	// Least recently used predictions are evicted first
+	TLruCache<uint32, FSmoothNavPrediction> Predictions{ MaxCachedPredictions };
+	TSet<uint32> PendingPredictions;
+	uint32 PredictionGeneration = 0;
+
+	TArray<FSmoothNavPredictionRequest> QueuedPredictions;
+	FTSTicker::FDelegateHandle QueuedPredictionsTickerHandle;
+	int32 NumSmoothedPredictions = 0;
+	double SmoothedPredictionTimeMs = 0.0;
+
+	TMap<FSmoothNavPathConfig, FSmoothNavPathDecisions, FDefaultSetAllocator, TSmoothNavPathConfigKeyFuncs<FSmoothNavPathDecisions>> SmoothingDecisions;
+
+	TMap<FNavAgentProperties, FSmoothNavAgentTypeData, FDefaultSetAllocator, TSmoothNavAgentPropertiesKeyFuncs<FSmoothNavAgentTypeData>> AgentTypeData;
+};
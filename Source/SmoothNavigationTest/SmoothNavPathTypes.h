@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/UnrealMathUtility.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "SmoothNavPathTypes.generated.h"
+
+enum class EAngleUnits : uint8 {
+	Degrees = 0,
+	Radians = 1	
+};
+
+template <typename VectorType>
+float GetAngleBetweenUnitVectors(const VectorType& a, const VectorType& b, EAngleUnits units = EAngleUnits::Radians)
+{
+	static_assert(std::is_same_v<FVector, VectorType>, "Only vector types supported");
+	
+	const float dotProduct = FVector::DotProduct(a, b);
+	const float angleInRadians = FMath::Acos(dotProduct);
+	return units == EAngleUnits::Radians ? angleInRadians : FMath::RadiansToDegrees(angleInRadians);
+}
+
+template<typename T>
+inline T GetBezierPoint(float t, T P0, T P1, T P2) {
+	float u = 1 - t;
+	float tt = t * t;
+	float uu = u * u;
+	T P = uu * P0;
+	P += 2 * u * t * P1;
+	P += tt * P2;
+	return P;
+}
+
+template<typename T>
+inline T GetCubicBezierPoint(float t, T P0, T P1, T P2, T P3) {
+	float u = 1 - t;
+	float tt = t * t;
+	float uu = u * u;
+	float uuu = uu * u;
+	float ttt = tt * t;
+	T P = uuu * P0; 
+	P += 3 * uu * t * P1; 
+	P += 3 * u * tt * P2; 
+	P += ttt * P3; 
+	return P;
+}
+
+USTRUCT(BlueprintType)
+struct FSmoothNavPathConfig
+{
+	GENERATED_BODY()
+
+	// How far along the direction vector will the first bias point be offset (resulting distance = full distance * Bias1_DistanceScalar)
+	UPROPERTY(EditAnywhere, Category="First Bias", meta=(ClampMin=0.1, ClampMax=1.f, UIMin = 0.1, UIMax = 1.f))
+	float Bias1_DistanceScalar = 0.5f;
+
+	// Max distance of how far along the direction vector will the second bias point be offset
+	UPROPERTY(EditAnywhere, Category="Second Bias", meta=(ClampMin=0.0, UIMin = 0.0, UIMax = 1000.f))
+	float Bias2_MaxDistanceOffset = 500.f;
+
+	// Min distance of how far along the direction vector will the second bias point be offset
+	UPROPERTY(EditAnywhere, Category="Second Bias", meta=(ClampMin=0.0, UIMin = 0.0, UIMax = 300.f))
+	float Bias2_MinDistanceOffset = 50.f;
+
+	// A configurable threshold for when the smooth path should attempt to skip certain nav points to maintain a smoother integrity (VERY EXPERIMENTAL)
+	UPROPERTY(EditAnywhere, Category="Nav Point Skipping", meta=(InlineEditConditionToggle))
+	bool bNavPointSkipping = true;
+
+	// A configurable threshold for when the smooth path should attempt to skip certain nav points to maintain a smoother integrity (VERY EXPERIMENTAL)
+	// Consecutive points turning less than this are collapsed into the farthest one that is still directly reachable
+	UPROPERTY(EditAnywhere, Category="Nav Point Skipping", meta=(EditCondition="bNavPointSkipping", ClampMin=0.f, UIMin = 0.f, UIMax = 90.f))
+	float MinAngleSkipThreshold = 20.f;
+
+	// A small offset to apply to next point in order to smooth out the turns more and avoid some inconsistencies
+	UPROPERTY(EditAnywhere, meta=(ClampMin=0.f, UIMin = 0.f, UIMax = 100.f))
+	float NextPointOffset = 50.0f;
+
+	// Return to default smooth path config values
+	UPROPERTY(EditAnywhere)
+	bool bResetToDefaultConfigValues = false;
+
+	// Extra debugging information. For now I am just toggling everything, but it's going to be separated out in the future
+	UPROPERTY(EditAnywhere, Category="Debugging")
+	bool bEnableExtraDebugInfo = false;
+
+	void ResetToDefaults()
+	{
+		Bias1_DistanceScalar = 0.5f;
+		Bias2_MaxDistanceOffset = 500.f;
+		Bias2_MinDistanceOffset = 50.f;
+		bNavPointSkipping = true;
+		MinAngleSkipThreshold = 20.f;
+		NextPointOffset = 50.0f;
+		bResetToDefaultConfigValues = false;
+		bEnableExtraDebugInfo = false;
+	}
+
+	// Hash of every value that affects the generated curve (debug toggles excluded)
+	uint32 GetConfigHash() const
+	{
+		uint32 hash = GetTypeHash(Bias1_DistanceScalar);
+		hash = HashCombine(hash, GetTypeHash(Bias2_MaxDistanceOffset));
+		hash = HashCombine(hash, GetTypeHash(Bias2_MinDistanceOffset));
+		hash = HashCombine(hash, GetTypeHash(bNavPointSkipping));
+		hash = HashCombine(hash, GetTypeHash(MinAngleSkipThreshold));
+		hash = HashCombine(hash, GetTypeHash(NextPointOffset));
+		return hash;
+	}
+
+	// Compares every value that goes into GetConfigHash
+	bool HasSameCurveSettings(const FSmoothNavPathConfig& other) const
+	{
+		return Bias1_DistanceScalar == other.Bias1_DistanceScalar
+			&& Bias2_MaxDistanceOffset == other.Bias2_MaxDistanceOffset
+			&& Bias2_MinDistanceOffset == other.Bias2_MinDistanceOffset
+			&& bNavPointSkipping == other.bNavPointSkipping
+			&& MinAngleSkipThreshold == other.MinAngleSkipThreshold
+			&& NextPointOffset == other.NextPointOffset;
+	}
+};
+
+// Map key functions for configs that only differ in their debug toggles. Equal hashes of different configs still get their own entries.
+template<typename ValueType>
+struct TSmoothNavPathConfigKeyFuncs : TDefaultMapKeyFuncs<FSmoothNavPathConfig, ValueType, false>
+{
+	static bool Matches(const FSmoothNavPathConfig& a, const FSmoothNavPathConfig& b) { return a.HasSameCurveSettings(b); }
+	static uint32 GetKeyHash(const FSmoothNavPathConfig& key) { return key.GetConfigHash(); }
+};
+
+// Smoothing decisions precomputed from a FSmoothNavPathConfig, so corners can be classified from dot products alone instead of an acos per corner
+struct FSmoothNavPathDecisions
+{
+	// Resolution of the second bias offset table
+	static constexpr int32 Bias2OffsetTableSize = 64;
+
+	// Skip when dot >= cos(MinAngleSkipThreshold), equivalent to angle <= MinAngleSkipThreshold
+	float SkipDotThreshold = 1.f;
+
+	// MapRangeClamped(angle, 0, 90, Bias2_MinDistanceOffset, Bias2_MaxDistanceOffset) sampled over sqrt(1 - dot).
+	// The angle is close to linear in sqrt(1 - dot), which keeps linear interpolation accurate near dot = 1 where acos is steepest.
+	float Bias2OffsetTable[Bias2OffsetTableSize + 1];
+	float Bias2_MaxDistanceOffset = 0.f;
+
+	void Build(const FSmoothNavPathConfig& config)
+	{
+		SkipDotThreshold = FMath::Cos(FMath::DegreesToRadians(config.MinAngleSkipThreshold));
+		Bias2_MaxDistanceOffset = config.Bias2_MaxDistanceOffset;
+		for(int32 i = 0; i <= Bias2OffsetTableSize; i++)
+		{
+			const float s = static_cast<float>(i) / Bias2OffsetTableSize;
+			const float angle = FMath::RadiansToDegrees(FMath::Acos(1.f - s * s));
+			Bias2OffsetTable[i] = FMath::GetMappedRangeValueClamped(FVector2f(0.f, 90.f), FVector2f(config.Bias2_MinDistanceOffset, config.Bias2_MaxDistanceOffset), angle);
+		}
+	}
+
+	bool ShouldSkip(float dot) const { return dot >= SkipDotThreshold; }
+
+	float GetBias2Offset(float dot) const
+	{
+		// Turns of 90 degrees or more always use the max offset
+		if(dot <= 0.f)
+		{
+			return Bias2_MaxDistanceOffset;
+		}
+
+		const float tableLocation = FMath::Sqrt(FMath::Max(0.f, 1.f - dot)) * Bias2OffsetTableSize;
+		const int32 index = FMath::Min(static_cast<int32>(tableLocation), Bias2OffsetTableSize - 1);
+		return FMath::Lerp(Bias2OffsetTable[index], Bias2OffsetTable[index + 1], tableLocation - index);
+	}
+};
+
+// Per corner data of a path, gathered in one pass over contiguous arrays before smoothing.
+// Segment i goes from point i to point i + 1, corner i is the turn at point i (first and last points have no corner).
+struct FSmoothNavPathCorners
+{
+	TArray<FVector> SegmentDirs;
+	TArray<float> CornerDots;
+	TArray<float> CornerBias2Offsets;
+
+	void Classify(const TArray<FNavPathPoint>& pathPoints, const FSmoothNavPathDecisions& decisions)
+	{
+		const int32 numPoints = pathPoints.Num();
+		SegmentDirs.SetNumUninitialized(FMath::Max(numPoints - 1, 0));
+		CornerDots.SetNumZeroed(numPoints);
+		CornerBias2Offsets.SetNumZeroed(numPoints);
+
+		for(int32 i = 0; i + 1 < numPoints; i++)
+		{
+			SegmentDirs[i] = (pathPoints[i + 1].Location - pathPoints[i].Location).GetSafeNormal();
+		}
+
+		// Separate passes over the flat arrays. No acos or map range per corner, the offsets are interpolated from the table of the decisions.
+		for(int32 i = 1; i + 1 < numPoints; i++)
+		{
+			CornerDots[i] = FMath::Clamp(static_cast<float>(FVector::DotProduct(SegmentDirs[i - 1], SegmentDirs[i])), -1.f, 1.f);
+		}
+		for(int32 i = 1; i + 1 < numPoints; i++)
+		{
+			CornerBias2Offsets[i] = decisions.GetBias2Offset(CornerDots[i]);
+		}
+	}
+};
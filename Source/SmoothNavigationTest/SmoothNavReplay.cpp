@@ -0,0 +1,351 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavReplay.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<bool> CVarSmoothNavReplayRecord(
+	TEXT("smoothnav.Replay.Record"),
+	false,
+	TEXT("Record every smoothing request, with the navmesh query results it used, to Saved/SmoothNav for offline replay with the SmoothNavReplay commandlet."));
+
+FArchive& operator<<(FArchive& Ar, FSmoothNavReplayQuery& Query)
+{
+	uint8 type = static_cast<uint8>(Query.Type);
+	Ar << type;
+	Query.Type = static_cast<FSmoothNavReplayQuery::EType>(type);
+
+	Ar << Query.InputA;
+	if(Query.Type == FSmoothNavReplayQuery::EType::Segment)
+	{
+		Ar << Query.InputB;
+		Ar << Query.bResult;
+		Ar << Query.NumRaycasts;
+	}
+	else if(Query.Type == FSmoothNavReplayQuery::EType::CorridorClamp)
+	{
+		Ar << Query.InputB;
+		Ar << Query.CurrentNodeRef;
+		Ar << Query.bDecided;
+		Ar << Query.bResult;
+	}
+	else
+	{
+		Ar << Query.CurrentNodeRef;
+		Ar << Query.NextNodeRef;
+	}
+	Ar << Query.Output;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FSmoothNavReplayRequest& Request)
+{
+	int32 numPoints = Request.PathPoints.Num();
+	Ar << numPoints;
+	if(Ar.IsLoading())
+	{
+		Request.PathPoints.SetNum(numPoints);
+	}
+	for(FNavPathPoint& pathPoint : Request.PathPoints)
+	{
+		Ar << pathPoint.Location;
+		Ar << pathPoint.NodeRef;
+		Ar << pathPoint.Flags;
+	}
+	Ar << Request.PathCorridor;
+
+	// Only what affects the curve, plus the debug toggle since it changes which checks run
+	FSmoothNavPathConfig& config = Request.Config;
+	Ar << config.Bias1_DistanceScalar;
+	Ar << config.Bias2_MaxDistanceOffset;
+	Ar << config.Bias2_MinDistanceOffset;
+	Ar << config.bNavPointSkipping;
+	Ar << config.MinAngleSkipThreshold;
+	Ar << config.NextPointOffset;
+	Ar << config.bEnableExtraDebugInfo;
+
+	uint8 storage = static_cast<uint8>(Request.Storage);
+	Ar << storage;
+	Request.Storage = static_cast<ESmoothPathStorage>(storage);
+
+	Ar << Request.FilterClassName;
+	Ar << Request.Queries;
+	Ar << Request.NumSamples;
+	Ar << Request.SamplesHash;
+	Ar << Request.RecordedTimeMs;
+	return Ar;
+}
+
+uint32 FSmoothNavReplayRequest::HashSamples(const TArray<FVector>& samples)
+{
+	uint32 hash = GetTypeHash(samples.Num());
+	for(const FVector& sample : samples)
+	{
+		hash = HashCombine(hash, GetTypeHash(sample));
+	}
+	return hash;
+}
+
+FSmoothNavPathRecordingQueries::FSmoothNavPathRecordingQueries(ISmoothNavPathQueries& inInnerQueries, FSmoothNavReplayRequest& inRequest)
+	: InnerQueries(inInnerQueries)
+	, Request(inRequest)
+{
+}
+
+void FSmoothNavPathRecordingQueries::PrepareQueries()
+{
+	InnerQueries.PrepareQueries();
+}
+
+bool FSmoothNavPathRecordingQueries::IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation)
+{
+	const int32 numRaycastsBefore = InnerQueries.GetNumRaycasts();
+	const bool bResult = InnerQueries.IsSegmentFullyOnNavmesh(segmentStart, segmentEnd, hitLocation);
+
+	FSmoothNavReplayQuery& query = Request.Queries.AddDefaulted_GetRef();
+	query.Type = FSmoothNavReplayQuery::EType::Segment;
+	query.InputA = segmentStart;
+	query.InputB = segmentEnd;
+	query.bResult = bResult;
+	query.Output = hitLocation;
+	query.NumRaycasts = static_cast<uint8>(InnerQueries.GetNumRaycasts() - numRaycastsBefore);
+	return bResult;
+}
+
+bool FSmoothNavPathRecordingQueries::IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd)
+{
+	const int32 numRaycastsBefore = InnerQueries.GetNumRaycasts();
+	const bool bResult = InnerQueries.IsSegmentClearOfEdges(segmentStart, segmentEnd);
+
+	// Recorded as a plain segment query, recordings from before the clearance check replay the same way
+	FSmoothNavReplayQuery& query = Request.Queries.AddDefaulted_GetRef();
+	query.Type = FSmoothNavReplayQuery::EType::Segment;
+	query.InputA = segmentStart;
+	query.InputB = segmentEnd;
+	query.bResult = bResult;
+	query.Output = segmentEnd;
+	query.NumRaycasts = static_cast<uint8>(InnerQueries.GetNumRaycasts() - numRaycastsBefore);
+	return bResult;
+}
+
+void FSmoothNavPathRecordingQueries::GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef)
+{
+	FSmoothNavReplayQuery& query = Request.Queries.AddDefaulted_GetRef();
+	query.Type = FSmoothNavReplayQuery::EType::SafeBias;
+	query.InputA = bias;
+	query.CurrentNodeRef = currentNodeRef;
+	query.NextNodeRef = nextNodeRef;
+
+	InnerQueries.GetSafeBiasLocation(bias, currentNodeRef, nextNodeRef);
+	query.Output = bias;
+}
+
+bool FSmoothNavPathRecordingQueries::ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation)
+{
+	const bool bDecided = InnerQueries.ClampSegmentToCorridor(segmentStart, segmentEnd, startNodeRef, bOutFullyOnNavmesh, outHitLocation);
+
+	FSmoothNavReplayQuery& query = Request.Queries.AddDefaulted_GetRef();
+	query.Type = FSmoothNavReplayQuery::EType::CorridorClamp;
+	query.InputA = segmentStart;
+	query.InputB = segmentEnd;
+	query.CurrentNodeRef = startNodeRef;
+	query.bDecided = bDecided;
+	query.bResult = bOutFullyOnNavmesh;
+	query.Output = outHitLocation;
+	return bDecided;
+}
+
+FSmoothNavPathReplayQueries::FSmoothNavPathReplayQueries(const FSmoothNavReplayRequest& inRequest)
+	: Request(inRequest)
+{
+}
+
+bool FSmoothNavPathReplayQueries::IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation)
+{
+	if(const FSmoothNavReplayQuery* query = ConsumeQuery(FSmoothNavReplayQuery::EType::Segment, segmentStart, segmentEnd))
+	{
+		NumRaycasts += query->NumRaycasts;
+		hitLocation = query->Output;
+		return query->bResult;
+	}
+
+	// Ran out of recorded answers, treat the segment as valid so the smoothing can still finish
+	return true;
+}
+
+bool FSmoothNavPathReplayQueries::IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd)
+{
+	if(const FSmoothNavReplayQuery* query = ConsumeQuery(FSmoothNavReplayQuery::EType::Segment, segmentStart, segmentEnd))
+	{
+		NumRaycasts += query->NumRaycasts;
+		return query->bResult;
+	}
+	return true;
+}
+
+void FSmoothNavPathReplayQueries::GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef)
+{
+	if(const FSmoothNavReplayQuery* query = ConsumeQuery(FSmoothNavReplayQuery::EType::SafeBias, bias, FVector::ZeroVector))
+	{
+		if(query->CurrentNodeRef != currentNodeRef || query->NextNodeRef != nextNodeRef)
+		{
+			++NumMismatches;
+		}
+		bias = query->Output;
+	}
+}
+
+bool FSmoothNavPathReplayQueries::ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation)
+{
+	if(const FSmoothNavReplayQuery* query = ConsumeQuery(FSmoothNavReplayQuery::EType::CorridorClamp, segmentStart, segmentEnd))
+	{
+		if(query->CurrentNodeRef != startNodeRef)
+		{
+			++NumMismatches;
+		}
+		bOutFullyOnNavmesh = query->bResult;
+		outHitLocation = query->Output;
+		return query->bDecided;
+	}
+
+	// Ran out of recorded answers, let the segment query decide it
+	return false;
+}
+
+const FSmoothNavReplayQuery* FSmoothNavPathReplayQueries::ConsumeQuery(FSmoothNavReplayQuery::EType type, const FVector& inputA, const FVector& inputB)
+{
+	if(!Request.Queries.IsValidIndex(NextQueryIndex))
+	{
+		++NumMismatches;
+		return nullptr;
+	}
+
+	// The recorded answer is used even on a mismatch, the count tells whether the replay can be trusted
+	const FSmoothNavReplayQuery& query = Request.Queries[NextQueryIndex++];
+	if(query.Type != type || !query.InputA.Equals(inputA) || (type != FSmoothNavReplayQuery::EType::SafeBias && !query.InputB.Equals(inputB)))
+	{
+		++NumMismatches;
+	}
+	return &query;
+}
+
+FSmoothNavReplayWriter* FSmoothNavReplayWriter::Get()
+{
+	static TUniquePtr<FSmoothNavReplayWriter> writer;
+	if(!CVarSmoothNavReplayRecord.GetValueOnGameThread())
+	{
+		return nullptr;
+	}
+
+	if(!writer.IsValid())
+	{
+		const FString filename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SmoothNav"), FString::Printf(TEXT("SmoothNavReplay-%s.bin"), *FDateTime::Now().ToString()));
+		writer.Reset(new FSmoothNavReplayWriter(filename));
+	}
+	return writer->FileWriter.IsValid() ? writer.Get() : nullptr;
+}
+
+FSmoothNavReplayWriter::FSmoothNavReplayWriter(const FString& inFilename)
+	: Filename(inFilename)
+{
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if(!FileWriter.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not create smooth nav replay file %s, recording is disabled."), *Filename);
+		return;
+	}
+
+	uint32 magic = FileMagic;
+	uint32 version = FileVersion;
+	*FileWriter << magic;
+	*FileWriter << version;
+	UE_LOG(LogTemp, Log, TEXT("Recording smoothing requests to %s"), *Filename);
+}
+
+FSmoothNavReplayWriter::~FSmoothNavReplayWriter()
+{
+	if(FileWriter.IsValid())
+	{
+		FileWriter->Close();
+	}
+}
+
+void FSmoothNavReplayWriter::Write(FSmoothNavReplayRequest& request)
+{
+	// Requests are appended as they come, flushing keeps the file usable even if the session crashes later on
+	*FileWriter << request;
+	FileWriter->Flush();
+}
+
+FSmoothNavReplayRecorder::FSmoothNavReplayRecorder(ISmoothNavPathQueries& inLiveQueries)
+	: Writer(FSmoothNavReplayWriter::Get())
+	, LiveQueries(inLiveQueries)
+	, RecordingQueries(inLiveQueries, Request)
+{
+}
+
+ISmoothNavPathQueries& FSmoothNavReplayRecorder::GetQueries()
+{
+	return Writer ? static_cast<ISmoothNavPathQueries&>(RecordingQueries) : LiveQueries;
+}
+
+TArray<FVector>* FSmoothNavReplayRecorder::GetSamples(TArray<FVector>* callerSamples)
+{
+	TArray<FVector>* samples = callerSamples || !Writer ? callerSamples : &RecordedSamples;
+	Samples = samples;
+	return samples;
+}
+
+void FSmoothNavReplayRecorder::Finish(const TArray<FNavPathPoint>& pathPoints, TConstArrayView<NavNodeRef> pathCorridor, const FSmoothNavPathConfig& config, ESmoothPathStorage storage, const FString& filterClassName, const FSmoothNavPathStats& stats)
+{
+	if(!Writer)
+	{
+		return;
+	}
+
+	Request.RecordedTimeMs = stats.TotalTimeMs;
+	Request.PathPoints = pathPoints;
+	Request.PathCorridor.Append(pathCorridor.GetData(), pathCorridor.Num());
+	Request.Config = config;
+	Request.Storage = storage;
+	Request.FilterClassName = filterClassName;
+	if(ensureMsgf(Samples, TEXT("Smooth with the samples of GetSamples, they are part of the recording")))
+	{
+		Request.NumSamples = Samples->Num();
+		Request.SamplesHash = FSmoothNavReplayRequest::HashSamples(*Samples);
+	}
+	Writer->Write(Request);
+}
+
+bool FSmoothNavReplayReader::Open(const FString& filename)
+{
+	FileReader.Reset(IFileManager::Get().CreateFileReader(*filename));
+	if(!FileReader.IsValid())
+	{
+		return false;
+	}
+
+	uint32 magic = 0;
+	uint32 version = 0;
+	*FileReader << magic;
+	*FileReader << version;
+	if(magic != FSmoothNavReplayWriter::FileMagic || version != FSmoothNavReplayWriter::FileVersion)
+	{
+		FileReader.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FSmoothNavReplayReader::ReadNext(FSmoothNavReplayRequest& outRequest)
+{
+	if(!FileReader.IsValid() || FileReader->AtEnd())
+	{
+		return false;
+	}
+
+	outRequest = FSmoothNavReplayRequest();
+	*FileReader << outRequest;
+	return !FileReader->IsError();
+}
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SmoothNavPathGenerator.h"
+
+// One navmesh query issued while smoothing, with the answer the navmesh gave
+struct FSmoothNavReplayQuery
+{
+	enum class EType : uint8
+	{
+		Segment = 0,
+		SafeBias = 1,
+		CorridorClamp = 2
+	};
+
+	EType Type = EType::Segment;
+
+	// Segment start and end, or the bias before clamping (InputA only)
+	FVector InputA = FVector::ZeroVector;
+	FVector InputB = FVector::ZeroVector;
+
+	// Poly refs of the current and next path point for SafeBias, the start poly (CurrentNodeRef only) for CorridorClamp
+	NavNodeRef CurrentNodeRef = INVALID_NAVNODEREF;
+	NavNodeRef NextNodeRef = INVALID_NAVNODEREF;
+
+	// CorridorClamp only, whether the corridor could decide the segment at all
+	bool bDecided = false;
+
+	// Segment and CorridorClamp: fully on navmesh and the hit location. SafeBias: the clamped bias.
+	bool bResult = false;
+	FVector Output = FVector::ZeroVector;
+
+	// Segment only, the navmesh raycasts the live query took to answer it
+	uint8 NumRaycasts = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FSmoothNavReplayQuery& Query);
+};
+
+// Everything needed to rerun one smoothing request without the navmesh it ran against
+struct FSmoothNavReplayRequest
+{
+	TArray<FNavPathPoint> PathPoints;
+	TArray<NavNodeRef> PathCorridor;
+	FSmoothNavPathConfig Config;
+	ESmoothPathStorage Storage = ESmoothPathStorage::Full;
+
+	// Path name of the navigation filter class the path was found with, "None" for the default filter or when the caller does not know it
+	FString FilterClassName;
+
+	// Queries in the order the smoothing issued them
+	TArray<FSmoothNavReplayQuery> Queries;
+
+	// Result fingerprint, compared against when replaying
+	int32 NumSamples = 0;
+	uint32 SamplesHash = 0;
+
+	// How long the original smoothing took, in milliseconds
+	double RecordedTimeMs = 0.0;
+
+	static uint32 HashSamples(const TArray<FVector>& samples);
+
+	friend FArchive& operator<<(FArchive& Ar, FSmoothNavReplayRequest& Request);
+};
+
+// Forwards to the live queries and records every answer into the request
+class FSmoothNavPathRecordingQueries : public ISmoothNavPathQueries
+{
+public:
+	FSmoothNavPathRecordingQueries(ISmoothNavPathQueries& inInnerQueries, FSmoothNavReplayRequest& inRequest);
+
+	virtual void PrepareQueries() override;
+	virtual bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) override;
+	virtual bool IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd) override;
+	virtual void GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef) override;
+	virtual bool ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation) override;
+	virtual int32 GetNumRaycasts() const override { return InnerQueries.GetNumRaycasts(); }
+
+private:
+	ISmoothNavPathQueries& InnerQueries;
+	FSmoothNavReplayRequest& Request;
+};
+
+// Answers the queries from a recording, in the order they were recorded. Nothing touches a navmesh.
+class FSmoothNavPathReplayQueries : public ISmoothNavPathQueries
+{
+public:
+	explicit FSmoothNavPathReplayQueries(const FSmoothNavReplayRequest& inRequest);
+
+	virtual bool IsSegmentFullyOnNavmesh(const FVector& segmentStart, const FVector& segmentEnd, FVector& hitLocation) override;
+	virtual bool IsSegmentClearOfEdges(const FVector& segmentStart, const FVector& segmentEnd) override;
+	virtual void GetSafeBiasLocation(FVector& bias, NavNodeRef currentNodeRef, NavNodeRef nextNodeRef) override;
+	virtual bool ClampSegmentToCorridor(const FVector& segmentStart, const FVector& segmentEnd, NavNodeRef startNodeRef, bool& bOutFullyOnNavmesh, FVector& outHitLocation) override;
+
+	// The raycasts the recorded queries took, nothing is raycast while replaying
+	virtual int32 GetNumRaycasts() const override { return NumRaycasts; }
+
+	// Queries that did not match the recorded sequence, any mismatch means the smoothing diverged from the recording
+	int32 GetNumMismatches() const { return NumMismatches; }
+	int32 GetNumUnusedQueries() const { return Request.Queries.Num() - NextQueryIndex; }
+
+private:
+	const FSmoothNavReplayQuery* ConsumeQuery(FSmoothNavReplayQuery::EType type, const FVector& inputA, const FVector& inputB);
+
+	const FSmoothNavReplayRequest& Request;
+	int32 NextQueryIndex = 0;
+	int32 NumMismatches = 0;
+	int32 NumRaycasts = 0;
+};
+
+// Streams recorded requests to a binary file under Saved/SmoothNav. Opt in with smoothnav.Replay.Record 1.
+class FSmoothNavReplayWriter
+{
+public:
+	static constexpr uint32 FileMagic = 0x534E5250; // 'SNRP'
+	// 2: next point offsets are queried up front, through CorridorClamp queries
+	// 3: segment queries store the number of raycasts they took
+	static constexpr uint32 FileVersion = 3;
+
+	// The writer of this session, or null while recording is disabled. The file is created on first use.
+	static FSmoothNavReplayWriter* Get();
+
+	~FSmoothNavReplayWriter();
+
+	void Write(FSmoothNavReplayRequest& request);
+
+	const FString& GetFilename() const { return Filename; }
+
+private:
+	explicit FSmoothNavReplayWriter(const FString& inFilename);
+
+	FString Filename;
+	TUniquePtr<FArchive> FileWriter;
+};
+
+// Records one smoothing request while smoothnav.Replay.Record is on. Every place that smooths a path goes through this.
+// Smooth with GetQueries() and GetSamples(), then call Finish. Without recording the live queries are used directly and Finish does nothing.
+class FSmoothNavReplayRecorder
+{
+public:
+	explicit FSmoothNavReplayRecorder(ISmoothNavPathQueries& inLiveQueries);
+
+	bool IsRecording() const { return Writer != nullptr; }
+
+	ISmoothNavPathQueries& GetQueries();
+
+	// Samples to smooth into. Recording needs them for the result fingerprint, even when the caller does not want them.
+	TArray<FVector>* GetSamples(TArray<FVector>* callerSamples);
+
+	// Write the request with the answers gathered while smoothing
+	void Finish(const TArray<FNavPathPoint>& pathPoints, TConstArrayView<NavNodeRef> pathCorridor, const FSmoothNavPathConfig& config, ESmoothPathStorage storage, const FString& filterClassName, const FSmoothNavPathStats& stats);
+
+private:
+	FSmoothNavReplayWriter* Writer = nullptr;
+	ISmoothNavPathQueries& LiveQueries;
+	FSmoothNavReplayRequest Request;
+	FSmoothNavPathRecordingQueries RecordingQueries;
+
+	TArray<FVector> RecordedSamples;
+	const TArray<FVector>* Samples = nullptr;
+};
+
+// Reads the requests of a recording back one by one
+class FSmoothNavReplayReader
+{
+public:
+	// False when the file is missing or not a recording of a supported version
+	bool Open(const FString& filename);
+
+	bool ReadNext(FSmoothNavReplayRequest& outRequest);
+
+private:
+	TUniquePtr<FArchive> FileReader;
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavReplayCommandlet.h"
+#include "SmoothNavReplay.h"
+
+int32 USmoothNavReplayCommandlet::Main(const FString& Params)
+{
+	FString filename;
+	if(!FParse::Value(*Params, TEXT("File="), filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SmoothNavReplay: missing File=<recording>"));
+		return 1;
+	}
+
+	int32 iterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), iterations);
+	iterations = FMath::Max(iterations, 1);
+
+	FSmoothNavReplayReader reader;
+	if(!reader.Open(filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SmoothNavReplay: %s is not a smooth nav recording of a supported version"), *filename);
+		return 1;
+	}
+
+	int32 numRequests = 0;
+	int32 numDiverged = 0;
+	double totalRecordedMs = 0.0;
+	double totalReplayedMs = 0.0;
+	double worstReplayedMs = 0.0;
+	int32 worstRequestIndex = INDEX_NONE;
+	int64 totalRaycasts = 0;
+	int64 totalCorrections = 0;
+
+	FSmoothNavReplayRequest request;
+	while(reader.ReadNext(request))
+	{
+		// Replay is headless, debug output would only measure the draw calls
+		request.Config.bEnableExtraDebugInfo = false;
+
+		FSmoothNavPathDecisions decisions;
+		decisions.Build(request.Config);
+
+		double fastestMs = UE_BIG_NUMBER;
+		bool bDiverged = false;
+		for(int32 iteration = 0; iteration < iterations; iteration++)
+		{
+			FSmoothNavPathReplayQueries replayQueries(request);
+			FSmoothNavPathGenerator generator(replayQueries, request.Config, decisions);
+
+			FCompactSmoothPath smoothedPath;
+			TArray<FVector> samples;
+			FSmoothNavPathStats stats;
+			generator.Smooth(request.PathPoints, request.Storage, smoothedPath, &samples, &stats);
+			fastestMs = FMath::Min(fastestMs, static_cast<double>(stats.TotalTimeMs));
+			if(iteration == 0)
+			{
+				totalRaycasts += stats.NumRaycasts;
+				totalCorrections += stats.NumCorrections;
+			}
+
+			bDiverged |= replayQueries.GetNumMismatches() > 0 || replayQueries.GetNumUnusedQueries() > 0
+				|| samples.Num() != request.NumSamples || FSmoothNavReplayRequest::HashSamples(samples) != request.SamplesHash;
+		}
+
+		if(bDiverged)
+		{
+			++numDiverged;
+			UE_LOG(LogTemp, Warning, TEXT("SmoothNavReplay: request %d (%d points) no longer reproduces the recorded result"), numRequests, request.PathPoints.Num());
+		}
+
+		if(fastestMs > worstReplayedMs)
+		{
+			worstReplayedMs = fastestMs;
+			worstRequestIndex = numRequests;
+		}
+		totalRecordedMs += request.RecordedTimeMs;
+		totalReplayedMs += fastestMs;
+		++numRequests;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("SmoothNavReplay: %d requests, %d diverged. Recorded %.3f ms, replayed %.3f ms (best of %d), slowest request %d at %.3f ms. %lld raycasts, %lld corrections"),
+		numRequests, numDiverged, totalRecordedMs, totalReplayedMs, iterations, worstRequestIndex, worstReplayedMs, totalRaycasts, totalCorrections);
+
+	return numDiverged > 0 ? 1 : 0;
+}
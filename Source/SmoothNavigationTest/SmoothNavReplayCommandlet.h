@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SmoothNavReplayCommandlet.generated.h"
+
+/**
+ * Reruns recorded smoothing requests against their recorded navmesh answers, without loading a map.
+ * Usage: -run=SmoothNavReplay File=<path to recording> [Iterations=<count>]
+ */
+UCLASS()
+class SMOOTHNAVIGATIONTEST_API USmoothNavReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual int32 Main(const FString& Params) override;
+};
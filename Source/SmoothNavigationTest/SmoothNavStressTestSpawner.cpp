@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmoothNavStressTestSpawner.h"
+#include "ATestingNavigatingActor.h"
+#include "GoalActor.h"
+#include "NavigationSystem.h"
+#include "SmoothNavPathSubsystem.h"
+#include "Misc/CommandLine.h"
+
+ASmoothNavStressTestSpawner::ASmoothNavStressTestSpawner()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void ASmoothNavStressTestSpawner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ApplyCommandLineOverrides();
+	RandomStream.Initialize(RandomSeed);
+}
+
+void ASmoothNavStressTestSpawner::ApplyCommandLineOverrides()
+{
+	const TCHAR* commandLine = FCommandLine::Get();
+	FParse::Value(commandLine, TEXT("SmoothNavStressAgents="), NumAgents);
+	FParse::Value(commandLine, TEXT("SmoothNavStressGoals="), NumGoals);
+	FParse::Value(commandLine, TEXT("SmoothNavStressRadius="), SpawnRadius);
+	FParse::Value(commandLine, TEXT("SmoothNavStressRepathInterval="), RepathInterval);
+	FParse::Value(commandLine, TEXT("SmoothNavStressCandidates="), CandidateGoalsPerAgent);
+	FParse::Value(commandLine, TEXT("SmoothNavStressReportInterval="), ReportInterval);
+	FParse::Value(commandLine, TEXT("SmoothNavStressSeed="), RandomSeed);
+	if(FParse::Value(commandLine, TEXT("SmoothNavStressDuration="), Duration))
+	{
+		bQuitWhenFinished = true;
+	}
+
+	NumAgents = FMath::Max(NumAgents, 1);
+	NumGoals = FMath::Max(NumGoals, 1);
+	ReportInterval = FMath::Max(ReportInterval, 0.1f);
+}
+
+void ASmoothNavStressTestSpawner::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if(bFinished)
+	{
+		return;
+	}
+
+	// The navmesh has to be ready before anything can be placed on it
+	if(!bSpawned)
+	{
+		bSpawned = TrySpawnActors();
+		return;
+	}
+
+	const double frameTimeMs = DeltaSeconds * 1000.0;
+	++WindowFrames;
+	WindowFrameTimeMs += frameTimeMs;
+	WindowMaxFrameTimeMs = FMath::Max(WindowMaxFrameTimeMs, frameTimeMs);
+
+	if(RepathInterval > 0.f && !Agents.IsEmpty())
+	{
+		// Spread the repaths so every agent repaths once per interval
+		PendingRepaths += Agents.Num() * DeltaSeconds / RepathInterval;
+		const int32 numRepaths = FMath::Min(FMath::FloorToInt(PendingRepaths), Agents.Num());
+		PendingRepaths -= numRepaths;
+		for(int32 i = 0; i < numRepaths; i++)
+		{
+			RepathAgent(Agents[NextRepathAgentIndex]);
+			NextRepathAgentIndex = (NextRepathAgentIndex + 1) % Agents.Num();
+		}
+	}
+
+	const double now = FPlatformTime::Seconds();
+	if(now - ReportWindowStartTime >= ReportInterval)
+	{
+		ReportStats(false);
+		ResetReportWindow();
+	}
+
+	if(Duration > 0.f && now - StartTime >= Duration)
+	{
+		bFinished = true;
+		ReportStats(true);
+		if(bQuitWhenFinished)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+bool ASmoothNavStressTestSpawner::TrySpawnActors()
+{
+	UWorld* world = GetWorld();
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+	if(!navSystem || !navSystem->GetDefaultNavDataInstance() || navSystem->IsNavigationBuildInProgress())
+	{
+		return false;
+	}
+
+	FActorSpawnParameters spawnParameters;
+	spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	Goals.Reserve(NumGoals);
+	for(int32 i = 0; i < NumGoals; i++)
+	{
+		FVector location;
+		if(GetRandomSpawnLocation(location))
+		{
+			Goals.Emplace(world->SpawnActor<AGoalActor>(AGoalActor::StaticClass(), location, FRotator::ZeroRotator, spawnParameters));
+		}
+	}
+
+	if(Goals.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: No navigable location found, nothing to stress test."), *GetName());
+		bFinished = true;
+		return true;
+	}
+
+	// The initial path of every agent is generated when it finishes spawning
+	const double spawnStartTime = FPlatformTime::Seconds();
+	Agents.Reserve(NumAgents);
+	for(int32 i = 0; i < NumAgents; i++)
+	{
+		FVector location;
+		if(!GetRandomSpawnLocation(location))
+		{
+			continue;
+		}
+
+		AATestingNavigatingActor* agent = world->SpawnActorDeferred<AATestingNavigatingActor>(AATestingNavigatingActor::StaticClass(), FTransform(location), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if(!agent)
+		{
+			continue;
+		}
+
+		// Thousands of persistent debug paths would measure the debug drawing instead of the smoothing
+		agent->bDebugDrawPath = false;
+		agent->bPredictivePreSmoothing = CandidateGoalsPerAgent > 0;
+		agent->GoalActor = Goals[RandomStream.RandRange(0, Goals.Num() - 1)];
+		for(int32 candidateIndex = 0; candidateIndex < CandidateGoalsPerAgent; candidateIndex++)
+		{
+			agent->CandidateGoalActors.Emplace(Goals[RandomStream.RandRange(0, Goals.Num() - 1)]);
+		}
+		agent->FinishSpawning(FTransform(location));
+		Agents.Emplace(agent);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("SmoothNavStress: spawned %d agents and %d goals in %.1f ms"), Agents.Num(), Goals.Num(), (FPlatformTime::Seconds() - spawnStartTime) * 1000.0);
+
+	StartTime = FPlatformTime::Seconds();
+	ResetReportWindow();
+	RunStartNumPredictions = WindowStartNumPredictions;
+	RunStartPredictionTimeMs = WindowStartPredictionTimeMs;
+	return true;
+}
+
+bool ASmoothNavStressTestSpawner::GetRandomSpawnLocation(FVector& outLocation) const
+{
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if(!navSystem)
+	{
+		return false;
+	}
+
+	FNavLocation navLocation;
+	const bool bFound = SpawnRadius > 0.f ? navSystem->GetRandomReachablePointInRadius(GetActorLocation(), SpawnRadius, navLocation) : navSystem->GetRandomPoint(navLocation);
+	outLocation = navLocation.Location;
+	return bFound;
+}
+
+void ASmoothNavStressTestSpawner::RepathAgent(AATestingNavigatingActor* agent)
+{
+	if(!IsValid(agent) || Goals.IsEmpty())
+	{
+		return;
+	}
+
+	// Pathfinding and smoothing both run synchronously in game worlds, a path set by this repath shows up as a new path generation
+	const uint32 pathGeneration = agent->GetPathGeneration();
+	const double repathStartTime = FPlatformTime::Seconds();
+	agent->SetGoalActor(PickNextGoal(agent));
+	const double repathTimeMs = (FPlatformTime::Seconds() - repathStartTime) * 1000.0;
+
+	++WindowRepaths;
+	WindowRepathTimeMs += repathTimeMs;
+	++TotalRepaths;
+
+	// Baked and predicted paths skip the smoothing. The stats of a prediction are from its earlier smoothing, which the subsystem counts when it happens.
+	const ESmoothPathSource pathSource = agent->GetPathGeneration() != pathGeneration ? agent->GetSmoothPathSource() : ESmoothPathSource::None;
+	switch(pathSource)
+	{
+	case ESmoothPathSource::Smoothed:
+		{
+			const FSmoothNavPathStats& stats = agent->LastSmoothPathStats;
+			++WindowSmoothedRepaths;
+			WindowSmoothingTimeMs += stats.TotalTimeMs;
+			WindowRaycasts += stats.NumRaycasts;
+			++TotalSmoothedRepaths;
+			TotalSmoothingTimeMs += stats.TotalTimeMs;
+			TotalRaycasts += stats.NumRaycasts;
+		}
+		break;
+	case ESmoothPathSource::Predicted:
+		++WindowPredictionHits;
+		++TotalPredictionHits;
+		break;
+	case ESmoothPathSource::Baked:
+		++WindowBakeHits;
+		++TotalBakeHits;
+		break;
+	default:
+		++WindowFailedRepaths;
+		++TotalFailedRepaths;
+		break;
+	}
+}
+
+AGoalActor* ASmoothNavStressTestSpawner::PickNextGoal(const AATestingNavigatingActor* agent)
+{
+	// Agents with candidate goals switch between them, which is what their predictions are smoothed for
+	const TArray<TObjectPtr<AGoalActor>>& goals = agent->CandidateGoalActors.IsEmpty() ? Goals : agent->CandidateGoalActors;
+	int32 goalIndex = RandomStream.RandRange(0, goals.Num() - 1);
+	if(goals[goalIndex] == agent->GoalActor)
+	{
+		goalIndex = (goalIndex + 1) % goals.Num();
+	}
+	return goals[goalIndex];
+}
+
+void ASmoothNavStressTestSpawner::ReportStats(bool bFinal)
+{
+	SIZE_T pathBytes = 0;
+	int32 numPaths = 0;
+	for(const TObjectPtr<AATestingNavigatingActor>& agent : Agents)
+	{
+		if(IsValid(agent) && !agent->GetSmoothedPath().IsEmpty())
+		{
+			pathBytes += agent->GetSmoothedPath().GetAllocatedSize();
+			++numPaths;
+		}
+	}
+	const double bytesPerPath = numPaths > 0 ? static_cast<double>(pathBytes) / numPaths : 0.0;
+
+	// Predictions are smoothed by the subsystem on the game thread, separately from the repaths that use them
+	const USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld());
+	const int32 numPredictions = smoothNavPathSubsystem ? smoothNavPathSubsystem->GetNumSmoothedPredictions() : 0;
+	const double predictionTimeMs = smoothNavPathSubsystem ? smoothNavPathSubsystem->GetSmoothedPredictionTimeMs() : 0.0;
+
+	if(bFinal)
+	{
+		const double elapsed = FPlatformTime::Seconds() - StartTime;
+		const int32 runPredictions = numPredictions - RunStartNumPredictions;
+		const double runPredictionTimeMs = predictionTimeMs - RunStartPredictionTimeMs;
+		UE_LOG(LogTemp, Display, TEXT("SmoothNavStress finished: %d agents, %.1f s, %lld repaths (%lld smoothed, %lld predicted, %lld baked, %lld failed), smoothing %.3f ms total (%.4f ms per path), %lld raycasts, %d predictions smoothed in %.3f ms, %d paths using %.1f bytes each"),
+			Agents.Num(), elapsed, TotalRepaths, TotalSmoothedRepaths, TotalPredictionHits, TotalBakeHits, TotalFailedRepaths,
+			TotalSmoothingTimeMs, TotalSmoothedRepaths > 0 ? TotalSmoothingTimeMs / TotalSmoothedRepaths : 0.0, TotalRaycasts,
+			runPredictions, runPredictionTimeMs, numPaths, bytesPerPath);
+		return;
+	}
+
+	const double avgFrameMs = WindowFrames > 0 ? WindowFrameTimeMs / WindowFrames : 0.0;
+	const double windowPredictionTimeMs = predictionTimeMs - WindowStartPredictionTimeMs;
+	UE_LOG(LogTemp, Display, TEXT("SmoothNavStress: frame %.2f ms avg / %.2f ms max, %d repaths (%d smoothed, %d predicted, %d baked, %d failed), repath %.3f ms per frame (smoothing %.3f ms), %.4f ms smoothing per path, %lld raycasts, %d predictions smoothed (%.3f ms per frame), %.1f bytes per path"),
+		avgFrameMs, WindowMaxFrameTimeMs, WindowRepaths, WindowSmoothedRepaths, WindowPredictionHits, WindowBakeHits, WindowFailedRepaths,
+		WindowFrames > 0 ? WindowRepathTimeMs / WindowFrames : 0.0,
+		WindowFrames > 0 ? WindowSmoothingTimeMs / WindowFrames : 0.0,
+		WindowSmoothedRepaths > 0 ? WindowSmoothingTimeMs / WindowSmoothedRepaths : 0.0,
+		WindowRaycasts,
+		numPredictions - WindowStartNumPredictions,
+		WindowFrames > 0 ? windowPredictionTimeMs / WindowFrames : 0.0,
+		bytesPerPath);
+}
+
+void ASmoothNavStressTestSpawner::ResetReportWindow()
+{
+	ReportWindowStartTime = FPlatformTime::Seconds();
+	WindowFrames = 0;
+	WindowFrameTimeMs = 0.0;
+	WindowMaxFrameTimeMs = 0.0;
+	WindowRepaths = 0;
+	WindowRepathTimeMs = 0.0;
+	WindowSmoothedRepaths = 0;
+	WindowPredictionHits = 0;
+	WindowBakeHits = 0;
+	WindowFailedRepaths = 0;
+	WindowSmoothingTimeMs = 0.0;
+	WindowRaycasts = 0;
+
+	const USmoothNavPathSubsystem* smoothNavPathSubsystem = UWorld::GetSubsystem<USmoothNavPathSubsystem>(GetWorld());
+	WindowStartNumPredictions = smoothNavPathSubsystem ? smoothNavPathSubsystem->GetNumSmoothedPredictions() : 0;
+	WindowStartPredictionTimeMs = smoothNavPathSubsystem ? smoothNavPathSubsystem->GetSmoothedPredictionTimeMs() : 0.0;
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SmoothNavStressTestSpawner.generated.h"
+
+class AATestingNavigatingActor;
+class AGoalActor;
+
+/**
+ * Spawns navigating and goal actors at random navigable locations and keeps repathing them, logging the cost of the smoothing at scale.
+ * Placed in a level or spawned by the game mode with -SmoothNavStress, e.g.
+ * ThirdPersonMap -game -nullrhi -unattended -SmoothNavStress -SmoothNavStressAgents=2000 -SmoothNavStressDuration=120
+ */
+UCLASS()
+class SMOOTHNAVIGATIONTEST_API ASmoothNavStressTestSpawner : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	ASmoothNavStressTestSpawner();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=1))
+	int32 NumAgents = 1000;
+
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=1))
+	int32 NumGoals = 100;
+
+	// Spawn within this navigable distance of the spawner, or anywhere on the navmesh when 0
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=0.f))
+	float SpawnRadius = 0.f;
+
+	// Every agent picks a new random goal this often (in seconds), one of its candidate goals when it has any. Repaths are spread evenly over the frames.
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=0.f))
+	float RepathInterval = 5.f;
+
+	// Number of candidate goals given to every agent, which enables predictive pre-smoothing for them
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=0))
+	int32 CandidateGoalsPerAgent = 0;
+
+	// Seconds between two reports in the log
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=0.1f))
+	float ReportInterval = 5.f;
+
+	// Stop after this many seconds, 0 runs until the game ends
+	UPROPERTY(EditAnywhere, Category="Stress Test", meta=(ClampMin=0.f))
+	float Duration = 0.f;
+
+	// Request an exit once Duration is over, for unattended runs
+	UPROPERTY(EditAnywhere, Category="Stress Test")
+	bool bQuitWhenFinished = false;
+
+	UPROPERTY(EditAnywhere, Category="Stress Test")
+	int32 RandomSeed = 1337;
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	// Apply -SmoothNavStressX= overrides from the command line
+	void ApplyCommandLineOverrides();
+
+	bool TrySpawnActors();
+	bool GetRandomSpawnLocation(FVector& outLocation) const;
+	void RepathAgent(AATestingNavigatingActor* agent);
+	AGoalActor* PickNextGoal(const AATestingNavigatingActor* agent);
+
+	void ReportStats(bool bFinal);
+	void ResetReportWindow();
+
+private:
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AATestingNavigatingActor>> Agents;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AGoalActor>> Goals;
+
+	FRandomStream RandomStream;
+	bool bSpawned = false;
+	bool bFinished = false;
+	double StartTime = 0.0;
+
+	// Round robin repath scheduling
+	int32 NextRepathAgentIndex = 0;
+	float PendingRepaths = 0.f;
+
+	// Current report window
+	double ReportWindowStartTime = 0.0;
+	int32 WindowFrames = 0;
+	double WindowFrameTimeMs = 0.0;
+	double WindowMaxFrameTimeMs = 0.0;
+	int32 WindowRepaths = 0;
+	double WindowRepathTimeMs = 0.0;
+	int32 WindowSmoothedRepaths = 0;
+	int32 WindowPredictionHits = 0;
+	int32 WindowBakeHits = 0;
+	int32 WindowFailedRepaths = 0;
+	double WindowSmoothingTimeMs = 0.0;
+	int64 WindowRaycasts = 0;
+
+	// Prediction counters of the subsystem at the start of the window and of the run
+	int32 WindowStartNumPredictions = 0;
+	double WindowStartPredictionTimeMs = 0.0;
+	int32 RunStartNumPredictions = 0;
+	double RunStartPredictionTimeMs = 0.0;
+
+	// Whole run
+	int64 TotalRepaths = 0;
+	int64 TotalSmoothedRepaths = 0;
+	int64 TotalPredictionHits = 0;
+	int64 TotalBakeHits = 0;
+	int64 TotalFailedRepaths = 0;
+	double TotalSmoothingTimeMs = 0.0;
+	int64 TotalRaycasts = 0;
+};
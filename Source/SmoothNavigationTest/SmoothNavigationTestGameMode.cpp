@@ -2,7 +2,10 @@
 
 #include "SmoothNavigationTestGameMode.h"
 #include "SmoothNavigationTestCharacter.h"
+#include "SmoothNavStressTestSpawner.h"
 #include "UObject/ConstructorHelpers.h"
+#include "EngineUtils.h"
+#include "Misc/CommandLine.h"
 
 ASmoothNavigationTestGameMode::ASmoothNavigationTestGameMode()
 {
@@ -13,3 +16,14 @@ ASmoothNavigationTestGameMode::ASmoothNavigationTestGameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+void ASmoothNavigationTestGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	// Unattended stress runs, see ASmoothNavStressTestSpawner for the options
+	if (FParse::Param(FCommandLine::Get(), TEXT("SmoothNavStress")) && !TActorIterator<ASmoothNavStressTestSpawner>(GetWorld()))
+	{
+		GetWorld()->SpawnActor<ASmoothNavStressTestSpawner>();
+	}
+}
@@ -13,6 +13,8 @@ class ASmoothNavigationTestGameMode : public AGameModeBase
 
 public:
 	ASmoothNavigationTestGameMode();
+
+	virtual void StartPlay() override;
 };
 
 
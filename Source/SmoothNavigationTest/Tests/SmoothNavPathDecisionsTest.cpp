@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "SmoothNavPathTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// The per corner math the decision tables replaced
+	float GetReferenceBias2Offset(const FSmoothNavPathConfig& config, const FVector& currentSegmentDir, const FVector& nextSegmentDir)
+	{
+		const float angle = GetAngleBetweenUnitVectors(currentSegmentDir, nextSegmentDir, EAngleUnits::Degrees);
+		return FMath::GetMappedRangeValueClamped(FVector2f(0.f, 90.f), FVector2f(config.Bias2_MinDistanceOffset, config.Bias2_MaxDistanceOffset), angle);
+	}
+
+	// Both segment directions of a turn by angle degrees, and their dot product clamped the way FSmoothNavPathCorners::Classify does it
+	void MakeTurn(float angle, FVector& outCurrentSegmentDir, FVector& outNextSegmentDir, float& outDot)
+	{
+		const float angleInRadians = FMath::DegreesToRadians(angle);
+		outCurrentSegmentDir = FVector(1.f, 0.f, 0.f);
+		outNextSegmentDir = FVector(FMath::Cos(angleInRadians), FMath::Sin(angleInRadians), 0.f);
+		outDot = FMath::Clamp(static_cast<float>(FVector::DotProduct(outCurrentSegmentDir, outNextSegmentDir)), -1.f, 1.f);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSmoothNavPathDecisionsTest, "SmoothNavigationTest.Decisions.MatchAngleReference", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSmoothNavPathDecisionsTest::RunTest(const FString& Parameters)
+{
+	// Defaults, a wide offset range with a small skip threshold and a near right angle skip threshold
+	TArray<FSmoothNavPathConfig> configs;
+	configs.AddDefaulted();
+	FSmoothNavPathConfig& wideConfig = configs.AddDefaulted_GetRef();
+	wideConfig.Bias2_MinDistanceOffset = 0.f;
+	wideConfig.Bias2_MaxDistanceOffset = 1000.f;
+	wideConfig.MinAngleSkipThreshold = 5.f;
+	FSmoothNavPathConfig& narrowConfig = configs.AddDefaulted_GetRef();
+	narrowConfig.Bias2_MinDistanceOffset = 120.f;
+	narrowConfig.Bias2_MaxDistanceOffset = 150.f;
+	narrowConfig.MinAngleSkipThreshold = 89.f;
+
+	constexpr float angleStep = 0.05f;
+	for(const FSmoothNavPathConfig& config : configs)
+	{
+		FSmoothNavPathDecisions decisions;
+		decisions.Build(config);
+
+		// Linear interpolation over sqrt(1 - dot) stays within a few thousandths of a degree of acos, scaled by the offset per degree
+		const float tolerance = FMath::Max(0.1f, FMath::Abs(config.Bias2_MaxDistanceOffset - config.Bias2_MinDistanceOffset) * 2.e-4f);
+		float maxOffsetError = 0.f;
+		int32 numSkipMismatches = 0;
+		for(float angle = 0.f; angle <= 180.f; angle += angleStep)
+		{
+			FVector currentSegmentDir;
+			FVector nextSegmentDir;
+			float dot;
+			MakeTurn(angle, currentSegmentDir, nextSegmentDir, dot);
+
+			const float offsetError = FMath::Abs(decisions.GetBias2Offset(dot) - GetReferenceBias2Offset(config, currentSegmentDir, nextSegmentDir));
+			maxOffsetError = FMath::Max(maxOffsetError, offsetError);
+
+			// Only exact ties at the threshold may round differently
+			const float referenceAngle = GetAngleBetweenUnitVectors(currentSegmentDir, nextSegmentDir, EAngleUnits::Degrees);
+			if(decisions.ShouldSkip(dot) != (referenceAngle <= config.MinAngleSkipThreshold) && !FMath::IsNearlyEqual(referenceAngle, config.MinAngleSkipThreshold, 1.e-3f))
+			{
+				++numSkipMismatches;
+			}
+		}
+
+		const FString configName = FString::Printf(TEXT("offsets %.0f-%.0f, skip %.0f deg"), config.Bias2_MinDistanceOffset, config.Bias2_MaxDistanceOffset, config.MinAngleSkipThreshold);
+		AddInfo(FString::Printf(TEXT("%s: max bias2 offset error %.4f"), *configName, maxOffsetError));
+		TestTrue(FString::Printf(TEXT("%s: bias2 offset table within %.3f of the acos reference"), *configName, tolerance), maxOffsetError <= tolerance);
+		TestEqual(FString::Printf(TEXT("%s: skip decisions differing from the angle comparison"), *configName), numSkipMismatches, 0);
+	}
+
+	// Rough cost per corner of both versions over the same turns. Only reported, timings are too noisy on shared machines to assert on.
+	constexpr int32 numTurns = 4096;
+	constexpr int32 numIterations = 64;
+	const FSmoothNavPathConfig& config = configs[0];
+	FSmoothNavPathDecisions decisions;
+	decisions.Build(config);
+
+	TArray<FVector> currentSegmentDirs;
+	TArray<FVector> nextSegmentDirs;
+	TArray<float> dots;
+	currentSegmentDirs.SetNumUninitialized(numTurns);
+	nextSegmentDirs.SetNumUninitialized(numTurns);
+	dots.SetNumUninitialized(numTurns);
+	for(int32 i = 0; i < numTurns; i++)
+	{
+		MakeTurn(180.f * i / numTurns, currentSegmentDirs[i], nextSegmentDirs[i], dots[i]);
+	}
+
+	float referenceSum = 0.f;
+	const uint64 referenceStartCycles = FPlatformTime::Cycles64();
+	for(int32 iteration = 0; iteration < numIterations; iteration++)
+	{
+		for(int32 i = 0; i < numTurns; i++)
+		{
+			referenceSum += GetReferenceBias2Offset(config, currentSegmentDirs[i], nextSegmentDirs[i]);
+		}
+	}
+	const double referenceMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - referenceStartCycles);
+
+	float tableSum = 0.f;
+	const uint64 tableStartCycles = FPlatformTime::Cycles64();
+	for(int32 iteration = 0; iteration < numIterations; iteration++)
+	{
+		for(int32 i = 0; i < numTurns; i++)
+		{
+			tableSum += decisions.GetBias2Offset(dots[i]);
+		}
+	}
+	const double tableMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - tableStartCycles);
+
+	// The sums keep the loops from being optimized away
+	const int32 numCorners = numTurns * numIterations;
+	AddInfo(FString::Printf(TEXT("%d corners: acos and map range %.3f ms (%.2f ns per corner), table %.3f ms (%.2f ns per corner), sums %.1f / %.1f"),
+		numCorners, referenceMs, referenceMs * 1.e6 / numCorners, tableMs, tableMs * 1.e6 / numCorners, referenceSum, tableSum));
+	return true;
+}
+
+#endif
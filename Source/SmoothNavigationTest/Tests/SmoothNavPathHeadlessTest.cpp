@@ -0,0 +1,278 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "SmoothNavPathLibrary.h"
+#include "ATestingNavigatingActor.h"
+#include "GoalActor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const TCHAR* HeadlessTestMap = TEXT("/Game/ThirdPerson/Maps/ThirdPersonMap");
+
+	// Long enough for a dynamic navmesh to finish its first build on a slow machine
+	constexpr double NavMeshWaitTimeoutSeconds = 120.0;
+
+	constexpr int32 NumHeadlessPaths = 16;
+	constexpr float HeadlessGoalRadius = 3000.f;
+
+	// Samples start and end on the raw path ends, up to the projection of the path ends onto the detail mesh
+	constexpr float PathEndTolerance = 10.f;
+
+	// Random paths are smoothed in each of these, to compare their cost
+	constexpr ESmoothPathStorage HeadlessStorageModes[] = { ESmoothPathStorage::Full, ESmoothPathStorage::Float, ESmoothPathStorage::Int16 };
+	constexpr int32 NumHeadlessStorageModes = UE_ARRAY_COUNT(HeadlessStorageModes);
+
+	// Length of the engine path between two points, negative when there is none
+	FVector::FReal GetPathLength(UNavigationSystemV1& navSystem, const ARecastNavMesh& navMesh, const FVector& startLocation, const FVector& goalLocation)
+	{
+		const FPathFindingQuery query(nullptr, navMesh, startLocation, goalLocation, navMesh.GetDefaultQueryFilter());
+		const FPathFindingResult pathFindingResult = navSystem.FindPathSync(query);
+		return pathFindingResult.IsSuccessful() ? pathFindingResult.Path->GetLength() : -1.0;
+	}
+}
+
+// Waits for the navmesh of the loaded map, then runs the test on it once
+class FSmoothNavNavMeshLatentCommand : public IAutomationLatentCommand
+{
+public:
+
+	explicit FSmoothNavNavMeshLatentCommand(FAutomationTestBase* inTest)
+		: Test(inTest)
+	{
+	}
+
+	virtual bool Update() override
+	{
+		UWorld* world = AutomationCommon::GetAnyGameWorld();
+		UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(world);
+		const ARecastNavMesh* navMesh = navSystem ? Cast<ARecastNavMesh>(navSystem->GetDefaultNavDataInstance()) : nullptr;
+		if(!navMesh || navSystem->IsNavigationBuildInProgress())
+		{
+			if(GetCurrentRunTime() > NavMeshWaitTimeoutSeconds)
+			{
+				Test->AddError(FString::Printf(TEXT("No navmesh in %s after %.0f seconds"), HeadlessTestMap, NavMeshWaitTimeoutSeconds));
+				return true;
+			}
+			return false;
+		}
+
+		RunWithNavMesh(*world, *navSystem, *navMesh);
+		return true;
+	}
+
+protected:
+
+	virtual void RunWithNavMesh(UWorld& world, UNavigationSystemV1& navSystem, const ARecastNavMesh& navMesh) = 0;
+
+	FAutomationTestBase* Test = nullptr;
+};
+
+// Smooths paths between random navigable points through the library entry points
+class FSmoothNavHeadlessPathsCommand : public FSmoothNavNavMeshLatentCommand
+{
+public:
+
+	using FSmoothNavNavMeshLatentCommand::FSmoothNavNavMeshLatentCommand;
+
+protected:
+
+	virtual void RunWithNavMesh(UWorld& world, UNavigationSystemV1& navSystem, const ARecastNavMesh& navMesh) override
+	{
+		// Debug toggles must not matter without a renderer
+		FSmoothNavPathConfig config;
+		config.bEnableExtraDebugInfo = true;
+
+		// Totals per entry of HeadlessStorageModes
+		double storageTimeMs[NumHeadlessStorageModes] = {};
+		SIZE_T storageAllocatedSize[NumHeadlessStorageModes] = {};
+		int32 storageNumPaths[NumHeadlessStorageModes] = {};
+
+		int32 numSmoothedPaths = 0;
+		for(int32 i = 0; i < NumHeadlessPaths; i++)
+		{
+			FNavLocation startLocation;
+			FNavLocation goalLocation;
+			if(!navSystem.GetRandomPoint(startLocation) || !navSystem.GetRandomReachablePointInRadius(startLocation.Location, HeadlessGoalRadius, goalLocation))
+			{
+				continue;
+			}
+
+			const FString pathName = FString::Printf(TEXT("Path %s -> %s"), *startLocation.Location.ToCompactString(), *goalLocation.Location.ToCompactString());
+
+			// Full precision samples from the blueprint entry point
+			TArray<FVector> pathPoints;
+			FSmoothNavPathStats stats;
+			if(!Test->TestTrue(pathName + TEXT(": FindSmoothPathSync succeeds"), USmoothNavPathLibrary::FindSmoothPathSync(&world, startLocation.Location, goalLocation.Location, FNavAgentProperties::DefaultProperties, config, nullptr, pathPoints, stats)))
+			{
+				continue;
+			}
+			if(!Test->TestTrue(pathName + TEXT(": FindSmoothPathSync returns samples"), pathPoints.Num() >= 2))
+			{
+				continue;
+			}
+			Test->TestTrue(pathName + TEXT(": first sample at the start"), FVector::Dist(pathPoints[0], startLocation.Location) <= PathEndTolerance);
+			Test->TestTrue(pathName + TEXT(": last sample at the goal"), FVector::Dist(pathPoints.Last(), goalLocation.Location) <= PathEndTolerance);
+			Test->TestTrue(pathName + TEXT(": every raw point accounted for"), stats.NumRawPoints >= 2 && stats.NumSkippedPoints < stats.NumRawPoints);
+
+			// Every storage mode through the entry point for paths that were already found
+			const FPathFindingQuery query(&world, navMesh, startLocation.Location, goalLocation.Location, UNavigationQueryFilter::GetQueryFilter(navMesh, &world, nullptr));
+			const FPathFindingResult pathFindingResult = navSystem.FindPathSync(query);
+			if(!Test->TestTrue(pathName + TEXT(": path found again"), pathFindingResult.IsSuccessful()))
+			{
+				continue;
+			}
+
+			const FVector& pathEndLocation = pathFindingResult.Path->GetPathPoints().Last().Location;
+			for(int32 storageIndex = 0; storageIndex < NumHeadlessStorageModes; storageIndex++)
+			{
+				const ESmoothPathStorage storage = HeadlessStorageModes[storageIndex];
+				const FString storageName = pathName + TEXT(" ") + StaticEnum<ESmoothPathStorage>()->GetNameStringByValue(static_cast<int64>(storage));
+
+				FCompactSmoothPath compactPath;
+				TArray<FVector> storagePathPoints;
+				FSmoothNavPathStats storageStats;
+				if(!Test->TestTrue(storageName + TEXT(": SmoothNavPath succeeds"), USmoothNavPathLibrary::SmoothNavPath(&world, navMesh, pathFindingResult.Path, config, storage, 0.f, compactPath, &storagePathPoints, &storageStats)))
+				{
+					continue;
+				}
+				Test->TestFalse(storageName + TEXT(": SmoothNavPath fills the compact path"), compactPath.IsEmpty());
+				if(Test->TestTrue(storageName + TEXT(": SmoothNavPath returns samples"), storagePathPoints.Num() >= 2))
+				{
+					// The end location is stored at full precision in every mode, only the control points are quantized
+					Test->TestTrue(storageName + TEXT(": last sample exactly at the path end"), storagePathPoints.Last() == pathEndLocation);
+				}
+
+				storageTimeMs[storageIndex] += storageStats.TotalTimeMs;
+				storageAllocatedSize[storageIndex] += compactPath.GetAllocatedSize();
+				++storageNumPaths[storageIndex];
+			}
+
+			++numSmoothedPaths;
+		}
+
+		Test->AddInfo(FString::Printf(TEXT("Smoothed %d of %d random paths"), numSmoothedPaths, NumHeadlessPaths));
+		for(int32 storageIndex = 0; storageIndex < NumHeadlessStorageModes; storageIndex++)
+		{
+			const int32 numPaths = FMath::Max(storageNumPaths[storageIndex], 1);
+			Test->AddInfo(FString::Printf(TEXT("%s storage: %d paths, %.3f ms and %.0f bytes per path"),
+				*StaticEnum<ESmoothPathStorage>()->GetNameStringByValue(static_cast<int64>(HeadlessStorageModes[storageIndex])),
+				storageNumPaths[storageIndex], storageTimeMs[storageIndex] / numPaths, static_cast<double>(storageAllocatedSize[storageIndex]) / numPaths));
+		}
+		Test->TestTrue(TEXT("At least one random path smoothed"), numSmoothedPaths > 0);
+	}
+};
+
+// Ranks a near and a far candidate goal with the multi-goal query and checks the ranking against the engine path lengths
+class FSmoothNavCandidateGoalOrderCommand : public FSmoothNavNavMeshLatentCommand
+{
+public:
+
+	using FSmoothNavNavMeshLatentCommand::FSmoothNavNavMeshLatentCommand;
+
+protected:
+
+	virtual void RunWithNavMesh(UWorld& world, UNavigationSystemV1& navSystem, const ARecastNavMesh& navMesh) override
+	{
+		// A start with one goal close by and one a lot further along the navmesh
+		constexpr int32 maxAttempts = 64;
+		constexpr float nearGoalRadius = 500.f;
+		constexpr FVector::FReal minPathLengthDifference = 1000.0;
+		FNavLocation startLocation;
+		FNavLocation nearGoalLocation;
+		FNavLocation farGoalLocation;
+		FVector::FReal nearPathLength = -1.0;
+		FVector::FReal farPathLength = -1.0;
+		bool bFoundGoals = false;
+		for(int32 attempt = 0; attempt < maxAttempts && !bFoundGoals; attempt++)
+		{
+			if(navSystem.GetRandomPoint(startLocation)
+				&& navSystem.GetRandomReachablePointInRadius(startLocation.Location, nearGoalRadius, nearGoalLocation)
+				&& navSystem.GetRandomReachablePointInRadius(startLocation.Location, HeadlessGoalRadius, farGoalLocation))
+			{
+				nearPathLength = GetPathLength(navSystem, navMesh, startLocation.Location, nearGoalLocation.Location);
+				farPathLength = GetPathLength(navSystem, navMesh, startLocation.Location, farGoalLocation.Location);
+				bFoundGoals = nearPathLength >= 0.0 && farPathLength >= nearPathLength + minPathLengthDifference;
+			}
+		}
+		if(!bFoundGoals)
+		{
+			Test->AddError(FString::Printf(TEXT("No start with goals at path distances at least %.0f apart in %s"), minPathLengthDifference, HeadlessTestMap));
+			return;
+		}
+
+		FActorSpawnParameters spawnParameters;
+		spawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AATestingNavigatingActor* agent = world.SpawnActor<AATestingNavigatingActor>(AATestingNavigatingActor::StaticClass(), startLocation.Location, FRotator::ZeroRotator, spawnParameters);
+		AGoalActor* nearGoal = world.SpawnActor<AGoalActor>(AGoalActor::StaticClass(), nearGoalLocation.Location, FRotator::ZeroRotator, spawnParameters);
+		AGoalActor* farGoal = world.SpawnActor<AGoalActor>(AGoalActor::StaticClass(), farGoalLocation.Location, FRotator::ZeroRotator, spawnParameters);
+		if(!Test->TestTrue(TEXT("Agent and goals spawned"), agent && nearGoal && farGoal))
+		{
+			return;
+		}
+
+		// The far goal goes first, so the order can only come from the costs
+		agent->bDebugDrawPath = false;
+		agent->bPredictivePreSmoothing = false;
+		agent->CandidateSearchDistance = farPathLength * 2.0;
+		agent->CandidateGoalActors = { farGoal, nearGoal };
+
+		TArray<FSmoothPathGoalCandidate> candidates;
+		const bool bAnyReachable = agent->EvaluateCandidateGoals(candidates);
+		if(Test->TestTrue(TEXT("Candidate goals evaluated"), bAnyReachable) && Test->TestEqual(TEXT("Candidates returned"), candidates.Num(), 2))
+		{
+			Test->TestTrue(TEXT("Both candidates reachable"), candidates[0].bReachable && candidates[1].bReachable);
+			Test->TestTrue(TEXT("Nearer goal ranked first"), candidates[0].GoalActor == nearGoal);
+
+			// The exploration walks from poly to poly, its costs can never be shorter than the straight line to the goal
+			for(const FSmoothPathGoalCandidate& candidate : candidates)
+			{
+				const FVector::FReal straightDistance = FVector::Dist(startLocation.Location, candidate.GoalActor->GetActorLocation());
+				Test->TestTrue(FString::Printf(TEXT("Cost %.1f of %s covers the straight distance %.1f"), candidate.PathCost, *candidate.GoalActor->GetName(), straightDistance), candidate.PathCost >= straightDistance - 1.0);
+			}
+			Test->AddInfo(FString::Printf(TEXT("Near goal: cost %.1f, path %.1f. Far goal: cost %.1f, path %.1f."),
+				candidates[0].PathCost, nearPathLength, candidates[1].PathCost, farPathLength));
+		}
+
+		agent->Destroy();
+		nearGoal->Destroy();
+		farGoal->Destroy();
+	}
+};
+
+// Both need a game world, so they only run in game and server contexts. Headless:
+// SmoothNavigationTest -server -nullrhi -unattended -ExecCmds="Automation RunTests SmoothNavigationTest.Headless; Quit"
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSmoothNavPathHeadlessTest, "SmoothNavigationTest.Headless.SmoothRandomPaths", EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FSmoothNavPathHeadlessTest::RunTest(const FString& Parameters)
+{
+	if(!AutomationOpenMap(HeadlessTestMap))
+	{
+		AddError(FString::Printf(TEXT("Failed to open %s"), HeadlessTestMap));
+		return false;
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FSmoothNavHeadlessPathsCommand(this));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSmoothNavCandidateGoalOrderTest, "SmoothNavigationTest.Headless.CandidateGoalOrder", EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FSmoothNavCandidateGoalOrderTest::RunTest(const FString& Parameters)
+{
+	if(!AutomationOpenMap(HeadlessTestMap))
+	{
+		AddError(FString::Printf(TEXT("Failed to open %s"), HeadlessTestMap));
+		return false;
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FSmoothNavCandidateGoalOrderCommand(this));
+	return true;
+}
+
+#endif